@@ -0,0 +1,125 @@
+/**
+ *  @file   allocguard.c
+ *  @brief  Abort on Heap Allocation in a Warm Frame Loop
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "allocguard.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// glibc's allocator under the names it keeps for interposers
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+// armed for the whole process, frames are counted by the loop alone
+static unsigned long frames;
+static volatile bool armed;
+static __thread bool exempt;
+
+// ncurses reallocates its windows when the terminal is resized
+static volatile sig_atomic_t winched;
+static struct sigaction chained;
+
+static void allocguard_winch(int sig, siginfo_t *info, void *context) {
+
+  winched = 1;
+
+  if (chained.sa_flags & SA_SIGINFO)
+    chained.sa_sigaction(sig, info, context);
+  else if (chained.sa_handler != SIG_DFL && chained.sa_handler != SIG_IGN)
+    chained.sa_handler(sig);
+}
+
+static void allocguard_trip(const char *what, size_t size) {
+
+  char msg[128];
+
+  armed = false;
+  int len = snprintf(msg, sizeof(msg),
+                     "\r\nallocguard: %s(%zu) after %lu warm frames\r\n", what,
+                     size, frames - ALLOCGUARDWARMUP);
+  write(STDERR_FILENO, msg, len);
+  abort();
+}
+
+void allocguard_frame(void) {
+
+  static bool installed;
+
+  // after initscr, which installs the handler of ncurses
+  if (!installed) {
+    struct sigaction action;
+    sigaction(SIGWINCH, NULL, &chained);
+    action.sa_sigaction = allocguard_winch;
+    action.sa_flags = SA_SIGINFO | (chained.sa_flags & SA_RESTART);
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGWINCH, &action, NULL);
+    installed = true;
+  }
+
+  if (winched) {
+    winched = 0;
+    frames = 0;
+    armed = false;
+  }
+
+  if (++frames >= ALLOCGUARDWARMUP)
+    armed = true;
+}
+
+void allocguard_exempt(void) { exempt = true; }
+
+void *malloc(size_t size) {
+
+  if (armed && !winched && !exempt)
+    allocguard_trip("malloc", size);
+
+  return (__libc_malloc(size));
+}
+
+void *calloc(size_t n, size_t size) {
+
+  if (armed && !winched && !exempt)
+    allocguard_trip("calloc", n * size);
+
+  return (__libc_calloc(n, size));
+}
+
+void *realloc(void *ptr, size_t size) {
+
+  if (armed && !winched && !exempt)
+    allocguard_trip("realloc", size);
+
+  return (__libc_realloc(ptr, size));
+}
+
+void *memalign(size_t alignment, size_t size) {
+
+  if (armed && !winched && !exempt)
+    allocguard_trip("memalign", size);
+
+  return (__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return (memalign(alignment, size));
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+
+  if ((*ptr = memalign(alignment, size)) == NULL)
+    return (ENOMEM);
+
+  return (0);
+}
@@ -0,0 +1,28 @@
+/**
+ *  @file   allocguard.h
+ *  @brief  Abort on Heap Allocation in a Warm Frame Loop
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef ALLOCGUARD_H_
+#define ALLOCGUARD_H_
+
+#define ALLOCGUARDWARMUP 100
+
+// built with ALLOCGUARD=1, once the frame loop went through
+// ALLOCGUARDWARMUP frames any heap allocation aborts, on the worker threads
+// of the loop as well as on the thread calling allocguard_frame; threads that
+// are not part of the loop exempt themselves; a resize of the terminal starts
+// the warm-up over; otherwise this is a no-op
+#ifdef ALLOCGUARD
+void allocguard_frame(void);
+void allocguard_exempt(void);
+#else
+static inline void allocguard_frame(void) {}
+static inline void allocguard_exempt(void) {}
+#endif
+
+#endif // ALLOCGUARD_H_
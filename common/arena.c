@@ -0,0 +1,46 @@
+/**
+ *  @file   arena.c
+ *  @brief  Bump Allocation from Reserved Address Space
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "arena.h"
+
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+int arena_init(struct arena *arena, size_t size) {
+
+  memset(arena, 0, sizeof(struct arena));
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED)
+    return (-1);
+
+  arena->base = (char *)base;
+  arena->size = size;
+
+  return (0);
+}
+
+void arena_trim(struct arena *arena) {
+
+  if (arena->peak > 0)
+    madvise(arena->base, arena->peak, MADV_DONTNEED);
+  arena->used = arena->peak = 0;
+}
+
+void arena_free(struct arena *arena) {
+
+  if (arena->base != NULL)
+    munmap(arena->base, arena->size);
+  memset(arena, 0, sizeof(struct arena));
+}
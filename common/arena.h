@@ -0,0 +1,48 @@
+/**
+ *  @file   arena.h
+ *  @brief  Bump Allocation from Reserved Address Space
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+
+#define ARENAALIGN 16
+
+// the address space is reserved once, pages are only backed once touched,
+// so an arena can be sized for the worst case and allocating never calls
+// into malloc
+struct arena {
+  char *base;
+  size_t size, used, peak;
+};
+
+int arena_init(struct arena *arena, size_t size);
+void arena_free(struct arena *arena);
+
+static inline void *arena_alloc(struct arena *arena, size_t size) {
+
+  size_t used = (arena->used + ARENAALIGN - 1) & ~(size_t)(ARENAALIGN - 1);
+
+  if (used > arena->size || size > arena->size - used)
+    return (NULL);
+
+  arena->used = used + size;
+  if (arena->used > arena->peak)
+    arena->peak = arena->used;
+
+  return (arena->base + used);
+}
+
+// everything allocated since is released at once
+static inline void arena_reset(struct arena *arena) { arena->used = 0; }
+
+// as arena_reset, and the pages touched are given back to the system
+void arena_trim(struct arena *arena);
+
+#endif // ARENA_H_
@@ -0,0 +1,272 @@
+/**
+ *  @file   metrics.c
+ *  @brief  Runtime Counters, Histograms and Export
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "metrics.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+uint64_t metrics_now(void) {
+
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static int metrics_connect(struct metrics *metrics) {
+
+  const char *target = metrics->target;
+
+  if (strncmp(target, "unix:", 5) != 0) {
+    metrics->socket = false;
+    metrics->fd = open(target, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    return (metrics->fd == -1 ? -1 : 0);
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strlen(target + 5) >= sizeof(addr.sun_path))
+    return (-1);
+  strcpy(addr.sun_path, target + 5);
+
+  // collectors listen on either kind of socket
+  int types[] = {SOCK_STREAM, SOCK_DGRAM};
+  for (int i = 0; i < 2; i++) {
+    int fd = socket(AF_UNIX, types[i], 0);
+    if (fd == -1)
+      return (-1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+#ifdef SO_NOSIGPIPE
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+      // a stalled collector must not stall the display
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      metrics->socket = true;
+      metrics->fd = fd;
+      return (0);
+    }
+    close(fd);
+    if (errno != EPROTOTYPE)
+      break;
+  }
+
+  return (-1);
+}
+
+int metrics_init(struct metrics *metrics, const char *prog,
+                 const char *target) {
+
+  memset(metrics, 0, sizeof(struct metrics));
+
+  metrics->prog = prog;
+  metrics->target = target;
+  metrics->fd = -1;
+
+  uint64_t now = metrics_now();
+  metrics->since = now;
+  metrics->roll = now + METRICSWINDOW;
+  metrics->export = now + METRICSINTERVAL;
+
+  if (target != NULL && metrics_connect(metrics) == -1)
+    return (-1);
+
+  return (0);
+}
+
+void metrics_free(struct metrics *metrics) {
+
+  if (metrics->fd != -1)
+    close(metrics->fd);
+  metrics->fd = -1;
+}
+
+static int metrics_register(struct metrics *metrics, const char *name,
+                            bool histogram, bool ns) {
+
+  if (metrics->n == METRICSMAX)
+    return (-1);
+
+  struct metric *metric = &metrics->metric[metrics->n];
+  metric->name = name;
+  metric->histogram = histogram;
+  metric->ns = ns;
+
+  return (metrics->n++);
+}
+
+int metrics_counter(struct metrics *metrics, const char *name) {
+  return (metrics_register(metrics, name, false, false));
+}
+
+int metrics_histogram(struct metrics *metrics, const char *name, bool ns) {
+  return (metrics_register(metrics, name, true, ns));
+}
+
+static void metrics_merge(struct metric_window *to,
+                          const struct metric_window *from) {
+
+  if (from->count == 0)
+    return;
+
+  if (to->count == 0 || from->min < to->min)
+    to->min = from->min;
+  if (from->max > to->max)
+    to->max = from->max;
+  to->count += from->count;
+  to->sum += from->sum;
+  for (int i = 0; i < METRICSBUCKETS; i++)
+    to->buckets[i] += from->buckets[i];
+}
+
+// largest value in the bucket
+static uint64_t metrics_bound(int bucket) {
+
+  if (bucket < METRICSSTEPS)
+    return (bucket);
+
+  int shift = bucket / METRICSSTEPS - 1;
+  uint64_t top = bucket % METRICSSTEPS + METRICSSTEPS;
+
+  return (((top + 1) << shift) - 1);
+}
+
+static uint64_t metrics_quantile(const struct metric_window *window,
+                                 int permille) {
+
+  uint64_t rank = (window->count * permille + 999) / 1000, seen = 0;
+
+  for (int i = 0; i < METRICSBUCKETS - 1; i++) {
+    if ((seen += window->buckets[i]) < rank)
+      continue;
+    uint64_t bound = metrics_bound(i);
+    if (bound < window->min)
+      bound = window->min;
+    return (bound < window->max ? bound : window->max);
+  }
+
+  return (window->max);
+}
+
+// graphite plaintext: prog.name[.field] value seconds
+static void metrics_export(struct metrics *metrics) {
+
+  if (metrics->fd == -1 &&
+      (!metrics->socket || metrics_connect(metrics) == -1))
+    return;
+
+  char *p = metrics->out, *end = metrics->out + METRICSOUT;
+  long now = (long)time(NULL);
+
+  for (int i = 0; i < metrics->n; i++) {
+    struct metric *metric = &metrics->metric[i];
+    struct metric_window *out = &metric->out;
+    const char *prog = metrics->prog, *name = metric->name;
+
+    if (end - p < 5 * METRICSLINE)
+      break;
+
+    if (!metric->histogram)
+      p += snprintf(p, end - p, "%s.%s %llu %ld\n", prog, name,
+                    (unsigned long long)out->sum, now);
+    else {
+      p += snprintf(p, end - p, "%s.%s.count %llu %ld\n", prog, name,
+                    (unsigned long long)out->count, now);
+      if (out->count > 0)
+        p += snprintf(p, end - p,
+                      "%s.%s.min %llu %ld\n%s.%s.p50 %llu %ld\n"
+                      "%s.%s.p99 %llu %ld\n%s.%s.max %llu %ld\n",
+                      prog, name, (unsigned long long)out->min, now, prog,
+                      name, (unsigned long long)metrics_quantile(out, 500),
+                      now, prog, name,
+                      (unsigned long long)metrics_quantile(out, 990), now,
+                      prog, name, (unsigned long long)out->max, now);
+    }
+    memset(out, 0, sizeof(struct metric_window));
+  }
+
+  size_t len = p - metrics->out;
+  ssize_t n;
+  if (metrics->socket)
+    n = send(metrics->fd, metrics->out, len, MSG_NOSIGNAL);
+  else
+    n = write(metrics->fd, metrics->out, len);
+
+  // a full socket drops the lines, a closed one is reconnected next time
+  if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && metrics->socket) {
+    close(metrics->fd);
+    metrics->fd = -1;
+  }
+}
+
+bool metrics_tick(struct metrics *metrics, uint64_t now) {
+
+  if (now < metrics->roll)
+    return (false);
+
+  for (int i = 0; i < metrics->n; i++) {
+    struct metric *metric = &metrics->metric[i];
+    metric->last = metric->cur;
+    metrics_merge(&metric->out, &metric->cur);
+    metric->total += metric->cur.sum;
+    memset(&metric->cur, 0, sizeof(struct metric_window));
+  }
+
+  metrics->span = now - metrics->since;
+  metrics->since = now;
+  metrics->roll = now + METRICSWINDOW;
+
+  if (now >= metrics->export) {
+    if (metrics->target != NULL)
+      metrics_export(metrics);
+    metrics->export = now + METRICSINTERVAL;
+  }
+
+  return (true);
+}
+
+bool metrics_hud(struct metrics *metrics, int line, char *buf, size_t size) {
+
+  if (line < 0 || line >= metrics->n)
+    return (false);
+
+  struct metric *metric = &metrics->metric[line];
+  struct metric_window *last = &metric->last;
+
+  if (!metric->histogram) {
+    unsigned long long rate =
+        metrics->span
+            ? (last->sum * 1000000000ull + metrics->span / 2) / metrics->span
+            : 0;
+    snprintf(buf, size, "%-9s %8llu/s %14llu", metric->name, rate,
+             (unsigned long long)metric->total);
+    return (true);
+  }
+
+  int scale = metric->ns ? 1000 : 1;
+  snprintf(buf, size, "%-9s p50 %7llu p99 %7llu max %7llu%s", metric->name,
+           (unsigned long long)metrics_quantile(last, 500) / scale,
+           (unsigned long long)metrics_quantile(last, 990) / scale,
+           (unsigned long long)last->max / scale, metric->ns ? " us" : "");
+
+  return (true);
+}
@@ -0,0 +1,107 @@
+/**
+ *  @file   metrics.h
+ *  @brief  Runtime Counters, Histograms and Export
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METRICSMAX 16
+#define METRICSOCTAVES 40
+#define METRICSSTEPS 8
+#define METRICSBUCKETS (METRICSOCTAVES * METRICSSTEPS)
+#define METRICSLINE 64
+#define METRICSOUT (METRICSMAX * 8 * METRICSLINE)
+
+// the HUD shows the last window, the export sums the windows since the last
+#define METRICSWINDOW 1000000000ull
+#define METRICSINTERVAL 10000000000ull
+
+// values are integers, durations in ns; histogram buckets split each power
+// of two in METRICSSTEPS, quantiles are reported as the upper bound of their
+// bucket within [min, max], i.e., at most 1 / METRICSSTEPS too high
+struct metric_window {
+  uint64_t count, sum, min, max;
+  uint32_t buckets[METRICSBUCKETS];
+};
+
+struct metric {
+  const char *name;
+  bool histogram, ns;
+  struct metric_window cur, last, out;
+  uint64_t total;
+};
+
+struct metrics {
+  const char *prog, *target;
+  struct metric metric[METRICSMAX];
+  int n, fd;
+  bool socket, hud;
+  uint64_t since, span, roll, export;
+  char out[METRICSOUT];
+};
+
+uint64_t metrics_now(void);
+
+// target is a file, appended to, or unix:path for a local socket; NULL for
+// no export
+int metrics_init(struct metrics *metrics, const char *prog,
+                 const char *target);
+void metrics_free(struct metrics *metrics);
+
+// register a metric, returns its id for metrics_add and metrics_observe
+int metrics_counter(struct metrics *metrics, const char *name);
+int metrics_histogram(struct metrics *metrics, const char *name, bool ns);
+
+// roll the window and export when due, returns true when the window rolled
+bool metrics_tick(struct metrics *metrics, uint64_t now);
+
+// line of the HUD, returns false past the last one
+bool metrics_hud(struct metrics *metrics, int line, char *buf, size_t size);
+
+// small values have a bucket each, others by their top bits
+static inline int metrics_bucket(uint64_t value) {
+
+  if (value < METRICSSTEPS)
+    return ((int)value);
+
+  int shift = 63 - __builtin_clzll(value) - __builtin_ctz(METRICSSTEPS),
+      bucket = shift * METRICSSTEPS + (int)(value >> shift);
+
+  return (bucket < METRICSBUCKETS ? bucket : METRICSBUCKETS - 1);
+}
+
+static inline void metrics_observe(struct metrics *metrics, int id,
+                                   uint64_t value) {
+
+  struct metric_window *window = &metrics->metric[id].cur;
+  int bucket = metrics_bucket(value);
+
+  ++window->buckets[bucket];
+
+  if (window->count == 0 || value < window->min)
+    window->min = value;
+  if (value > window->max)
+    window->max = value;
+  ++window->count;
+  window->sum += value;
+}
+
+static inline void metrics_add(struct metrics *metrics, int id,
+                               uint64_t value) {
+
+  struct metric_window *window = &metrics->metric[id].cur;
+
+  ++window->count;
+  window->sum += value;
+}
+
+#endif // METRICS_H_
@@ -0,0 +1,128 @@
+/**
+ *  @file   pool.c
+ *  @brief  Fixed Pool of Worker Threads
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "pool.h"
+#include "trace.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+// claims tasks until none are left, with the lock held on entry and exit
+static void pool_drain(struct pool *pool) {
+
+  while (pool->next < pool->ntasks) {
+    int i = pool->next++;
+    pthread_mutex_unlock(&pool->lock);
+    pool->task(pool->arg, i);
+    pthread_mutex_lock(&pool->lock);
+    if (++pool->finished == pool->ntasks)
+      pthread_cond_signal(&pool->done);
+  }
+}
+
+static void *pool_worker(void *arg) {
+
+  struct pool *pool = (struct pool *)arg;
+
+  trace_thread("pool");
+
+  pthread_mutex_lock(&pool->lock);
+
+  unsigned long seen = pool->generation;
+
+  while (true) {
+    while (!pool->quit && pool->generation == seen)
+      pthread_cond_wait(&pool->start, &pool->lock);
+    if (pool->quit)
+      break;
+    seen = pool->generation;
+    pool_drain(pool);
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+
+  return (NULL);
+}
+
+int pool_init(struct pool *pool, int nthreads) {
+
+  memset(pool, 0, sizeof(struct pool));
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  if (nthreads < 1)
+    return (0);
+
+  pool->threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+  if (pool->threads == NULL) {
+    pool_free(pool);
+    return (-1);
+  }
+
+  // signals, SIGWINCH in particular, are left to the main thread
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  for (; pool->nthreads < nthreads; pool->nthreads++)
+    if (pthread_create(&pool->threads[pool->nthreads], NULL, pool_worker,
+                       pool) != 0)
+      break;
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (pool->nthreads < nthreads) {
+    pool_free(pool);
+    return (-1);
+  }
+
+  return (0);
+}
+
+void pool_free(struct pool *pool) {
+
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->nthreads; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  free(pool->threads);
+  pool->threads = NULL;
+  pool->nthreads = 0;
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+}
+
+void pool_run(struct pool *pool, pool_task task, void *arg, int ntasks) {
+
+  pthread_mutex_lock(&pool->lock);
+
+  pool->task = task;
+  pool->arg = arg;
+  pool->ntasks = ntasks;
+  pool->next = pool->finished = 0;
+  ++pool->generation;
+  if (pool->nthreads > 0 && ntasks > 1)
+    pthread_cond_broadcast(&pool->start);
+
+  pool_drain(pool);
+
+  while (pool->finished < pool->ntasks)
+    pthread_cond_wait(&pool->done, &pool->lock);
+
+  pthread_mutex_unlock(&pool->lock);
+}
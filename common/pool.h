@@ -0,0 +1,38 @@
+/**
+ *  @file   pool.h
+ *  @brief  Fixed Pool of Worker Threads
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+
+typedef void (*pool_task)(void *arg, int i);
+
+// the workers sleep between runs, the caller takes tasks alongside them
+struct pool {
+  pthread_t *threads;
+  int nthreads;
+  pthread_mutex_t lock;
+  pthread_cond_t start, done;
+  pool_task task;
+  void *arg;
+  int ntasks, next, finished;
+  unsigned long generation;
+  bool quit;
+};
+
+// nthreads workers besides the caller, 0 runs every task on the caller
+int pool_init(struct pool *pool, int nthreads);
+void pool_free(struct pool *pool);
+
+// task(arg, i) for i in [0, ntasks), returns once all have
+void pool_run(struct pool *pool, pool_task task, void *arg, int ntasks);
+
+#endif // POOL_H_
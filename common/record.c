@@ -0,0 +1,434 @@
+/**
+ *  @file   record.c
+ *  @brief  Binary Frame Recording and Replay
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "record.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// varints for skip, count and a cell that changes pen, with room to spare
+#define RECORDCELLBYTES 32
+#define RECORDBUFFER (1 << 20)
+
+static const struct cell blank = {L' ', -1, -1, 0};
+
+static inline bool record_same_pen(const struct cell *a,
+                                   const struct cell *b) {
+  return (a->fg == b->fg && a->bg == b->bg && a->attr == b->attr);
+}
+
+static inline bool record_same(const struct cell *a, const struct cell *b) {
+  return (a->ch == b->ch && record_same_pen(a, b));
+}
+
+static inline size_t record_pad(size_t size) { return ((size + 7) & ~7); }
+
+static uint64_t record_now(void) {
+
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static unsigned char *record_varint(unsigned char *p, uint32_t value) {
+
+  while (value >= 0x80) {
+    *p++ = value | 0x80;
+    value >>= 7;
+  }
+  *p++ = value;
+
+  return (p);
+}
+
+static const unsigned char *record_get_varint(const unsigned char *p,
+                                              const unsigned char *end,
+                                              uint32_t *value) {
+
+  *value = 0;
+  for (int shift = 0; p < end && shift < 35; shift += 7) {
+    *value |= (uint32_t)(*p & 0x7f) << shift;
+    if (!(*p++ & 0x80))
+      return (p);
+  }
+
+  return (NULL);
+}
+
+int record_open(struct record *record, const char *path) {
+
+  memset(record, 0, sizeof(struct record));
+
+  if (arena_init(&record->arena,
+                 RECORDMAXINDEX * sizeof(struct record_index)) == -1)
+    return (-1);
+  record->index = (struct record_index *)record->arena.base;
+
+  if ((record->file = fopen(path, "wb")) == NULL) {
+    arena_free(&record->arena);
+    return (-1);
+  }
+  setvbuf(record->file, NULL, _IOFBF, RECORDBUFFER);
+
+  struct record_header header = {RECORDMAGIC, RECORDVERSION};
+  if (fwrite(&header, sizeof(header), 1, record->file) != 1) {
+    fclose(record->file);
+    record->file = NULL;
+    arena_free(&record->arena);
+    return (-1);
+  }
+
+  record->offset = sizeof(header);
+  record->start = record_now();
+
+  return (0);
+}
+
+void record_close(struct record *record) {
+
+  if (record->file != NULL) {
+    struct record_trailer trailer = {record->offset, record->nindex,
+                                     RECORDINDEXMAGIC};
+    fwrite(record->index, sizeof(struct record_index), record->nindex,
+           record->file);
+    fwrite(&trailer, sizeof(trailer), 1, record->file);
+    fclose(record->file);
+  }
+
+  free(record->prev);
+  free(record->buf);
+  arena_free(&record->arena);
+  memset(record, 0, sizeof(struct record));
+}
+
+static int record_alloc(struct record *record, int rows, int cols) {
+
+  size_t ncells = (size_t)rows * cols,
+         buf_size = sizeof(struct record_frame) + ncells * RECORDCELLBYTES + 8;
+
+  struct cell *prev =
+      (struct cell *)realloc(record->prev, ncells * sizeof(struct cell));
+  if (prev == NULL)
+    return (-1);
+  record->prev = prev;
+
+  unsigned char *buf = (unsigned char *)realloc(record->buf, buf_size);
+  if (buf == NULL)
+    return (-1);
+  record->buf = buf;
+  record->buf_size = buf_size;
+
+  record->rows = rows;
+  record->cols = cols;
+
+  return (0);
+}
+
+int record_frame(struct record *record, const struct cell *cells, int rows,
+                 int cols) {
+
+  if (record->file == NULL)
+    return (-1);
+
+  bool key = record->lost ||
+             record->since_key >= RECORDKEYRATIO * record->key_size;
+
+  if (rows != record->rows || cols != record->cols) {
+    if (record_alloc(record, rows, cols) == -1)
+      return (-1);
+    key = true;
+  }
+
+  size_t ncells = (size_t)rows * cols, last = 0, changed = 0;
+  unsigned char *p = record->buf + sizeof(struct record_frame);
+  const struct cell *pen = &blank;
+
+  for (size_t i = 0; i < ncells;) {
+    if (!key && record_same(&cells[i], &record->prev[i])) {
+      ++i;
+      continue;
+    }
+    size_t run = i + 1;
+    while (run < ncells &&
+           (key || !record_same(&cells[run], &record->prev[run])))
+      ++run;
+    p = record_varint(p, i - last);
+    p = record_varint(p, run - i);
+    changed += run - i;
+    for (; i < run; i++) {
+      bool same_pen = record_same_pen(&cells[i], pen);
+      p = record_varint(p, (uint32_t)cells[i].ch << 1 | same_pen);
+      if (!same_pen) {
+        p = record_varint(p, cells[i].fg + 1);
+        p = record_varint(p, cells[i].bg + 1);
+        p = record_varint(p, cells[i].attr);
+      }
+      pen = record->prev + i;
+      record->prev[i] = cells[i];
+    }
+    last = run;
+  }
+
+  if (changed == 0)
+    return (0);
+
+  size_t size = p - record->buf;
+  memset(p, 0, record_pad(size) - size);
+  size = record_pad(size);
+
+  struct record_frame *frame = (struct record_frame *)record->buf;
+  frame->ns = record_now() - record->start;
+  frame->size = size;
+  frame->rows = rows;
+  frame->cols = cols;
+  frame->key = key;
+  frame->ncells = changed;
+
+  // prev already holds this frame, so one that is not stored whole is
+  // overwritten by a keyframe
+  if (fwrite(record->buf, size, 1, record->file) != 1) {
+    fseeko(record->file, record->offset, SEEK_SET);
+    record->lost = true;
+    return (-1);
+  }
+
+  record->lost = false;
+
+  // entries are ARENAALIGN bytes, so they follow each other; a keyframe
+  // without one is only missing as a seek target
+  if (key && arena_alloc(&record->arena, sizeof(struct record_index))) {
+    record->index[record->nindex].offset = record->offset;
+    record->index[record->nindex++].ns = frame->ns;
+  }
+
+  if (key) {
+    record->key_size = size;
+    record->since_key = 0;
+  } else
+    record->since_key += size;
+
+  record->offset += size;
+  ++record->frames;
+
+  return (0);
+}
+
+static const struct record_frame *replay_frame(struct replay *replay,
+                                               size_t offset) {
+
+  if (offset + sizeof(struct record_frame) > replay->end)
+    return (NULL);
+
+  const struct record_frame *frame =
+      (const struct record_frame *)(replay->map + offset);
+  if (frame->size < sizeof(struct record_frame) || frame->size % 8 ||
+      offset + frame->size > replay->end)
+    return (NULL);
+
+  return (frame);
+}
+
+// without a trailer, e.g., after a crash, keyframes are found by walking
+static int replay_scan(struct replay *replay) {
+
+  size_t offset = sizeof(struct record_header), cap = 0;
+  const struct record_frame *frame;
+
+  replay->end = replay->size;
+  replay->own_index = true;
+
+  while ((frame = replay_frame(replay, offset)) != NULL) {
+    if (frame->key) {
+      if (replay->nindex == cap) {
+        cap = cap ? 2 * cap : 64;
+        struct record_index *index = (struct record_index *)realloc(
+            replay->index, cap * sizeof(struct record_index));
+        if (index == NULL)
+          return (-1);
+        replay->index = index;
+      }
+      replay->index[replay->nindex].offset = offset;
+      replay->index[replay->nindex++].ns = frame->ns;
+    }
+    offset += frame->size;
+  }
+  replay->end = offset;
+
+  return (0);
+}
+
+int replay_open(struct replay *replay, const char *path) {
+
+  memset(replay, 0, sizeof(struct replay));
+
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return (-1);
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(struct record_header)) {
+    close(fd);
+    return (-1);
+  }
+
+  replay->size = st.st_size;
+  void *map = mmap(NULL, replay->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return (-1);
+  replay->map = (const unsigned char *)map;
+
+  const struct record_header *header = (const struct record_header *)map;
+  if (header->magic != RECORDMAGIC || header->version != RECORDVERSION) {
+    replay_close(replay);
+    return (-1);
+  }
+
+  const struct record_trailer *trailer = NULL;
+  if (replay->size >=
+      sizeof(struct record_header) + sizeof(struct record_trailer))
+    trailer = (const struct record_trailer *)(replay->map + replay->size -
+                                              sizeof(struct record_trailer));
+
+  if (trailer != NULL && trailer->magic == RECORDINDEXMAGIC &&
+      trailer->index >= sizeof(struct record_header) &&
+      trailer->index + trailer->nindex * sizeof(struct record_index) +
+              sizeof(struct record_trailer) ==
+          replay->size) {
+    replay->index = (struct record_index *)(replay->map + trailer->index);
+    replay->nindex = trailer->nindex;
+    replay->end = trailer->index;
+  } else if (replay_scan(replay) == -1) {
+    replay_close(replay);
+    return (-1);
+  }
+
+  // the last frame follows the last keyframe
+  size_t offset = replay->nindex ? replay->index[replay->nindex - 1].offset
+                                 : replay->end;
+  const struct record_frame *frame;
+  while ((frame = replay_frame(replay, offset)) != NULL) {
+    replay->duration = frame->ns;
+    offset += frame->size;
+  }
+
+  // a resize starts with a keyframe, so the largest is among them
+  size_t ncells = 0;
+  for (size_t i = 0; i < replay->nindex; i++)
+    if ((frame = replay_frame(replay, replay->index[i].offset)) != NULL &&
+        (size_t)frame->rows * frame->cols > ncells)
+      ncells = (size_t)frame->rows * frame->cols;
+  if (ncells > 0 && (replay->cells = (struct cell *)malloc(
+                         ncells * sizeof(struct cell))) == NULL) {
+    replay_close(replay);
+    return (-1);
+  }
+
+  replay->offset = sizeof(struct record_header);
+
+  return (0);
+}
+
+void replay_close(struct replay *replay) {
+
+  if (replay->own_index)
+    free(replay->index);
+  if (replay->map != NULL)
+    munmap((void *)replay->map, replay->size);
+  free(replay->cells);
+  memset(replay, 0, sizeof(struct replay));
+}
+
+int replay_next(struct replay *replay) {
+
+  const struct record_frame *frame = replay_frame(replay, replay->offset);
+  if (frame == NULL)
+    return (0);
+
+  if (frame->rows != replay->rows || frame->cols != replay->cols) {
+    if (!frame->key)
+      return (-1);
+    size_t ncells = (size_t)frame->rows * frame->cols;
+    for (size_t i = 0; i < ncells; i++)
+      replay->cells[i] = blank;
+    replay->rows = frame->rows;
+    replay->cols = frame->cols;
+  }
+
+  const unsigned char *p = (const unsigned char *)(frame + 1),
+                      *end = replay->map + replay->offset + frame->size;
+  size_t ncells = (size_t)replay->rows * replay->cols, pos = 0, done = 0;
+  struct cell pen = blank;
+  uint32_t skip, count, value;
+
+  while (done < frame->ncells) {
+    if ((p = record_get_varint(p, end, &skip)) == NULL ||
+        (p = record_get_varint(p, end, &count)) == NULL ||
+        (pos += skip) + count > ncells)
+      return (-1);
+    for (uint32_t i = 0; i < count; i++, pos++) {
+      if ((p = record_get_varint(p, end, &value)) == NULL)
+        return (-1);
+      if (!(value & 1)) {
+        uint32_t fg, bg, attr;
+        if ((p = record_get_varint(p, end, &fg)) == NULL ||
+            (p = record_get_varint(p, end, &bg)) == NULL ||
+            (p = record_get_varint(p, end, &attr)) == NULL)
+          return (-1);
+        pen.fg = (short)fg - 1;
+        pen.bg = (short)bg - 1;
+        pen.attr = attr;
+      }
+      pen.ch = value >> 1;
+      replay->cells[pos] = pen;
+    }
+    done += count;
+  }
+
+  replay->ns = frame->ns;
+  replay->offset += frame->size;
+  ++replay->frames;
+
+  return (1);
+}
+
+int replay_seek(struct replay *replay, uint64_t ns) {
+
+  size_t lo = 0, hi = replay->nindex;
+
+  if (hi == 0)
+    return (0);
+
+  // last keyframe at or before ns
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (replay->index[mid].ns <= ns)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  replay->offset = replay->index[lo].offset;
+
+  int status = replay_next(replay);
+  const struct record_frame *frame;
+  while (status == 1 &&
+         (frame = replay_frame(replay, replay->offset)) != NULL &&
+         frame->ns <= ns)
+    status = replay_next(replay);
+
+  return (status);
+}
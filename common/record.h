@@ -0,0 +1,100 @@
+/**
+ *  @file   record.h
+ *  @brief  Binary Frame Recording and Replay
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef RECORD_H_
+#define RECORD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "term.h"
+
+#define RECORDMAGIC 0x43455254 // "TREC"
+#define RECORDINDEXMAGIC 0x58444954 // "TIDX"
+#define RECORDVERSION 1
+#define RECORDKEYRATIO 4
+#define RECORDMAXINDEX (1 << 22)
+
+// file: header, frames, index, trailer; all in host byte order
+//
+// a keyframe follows once the deltas since the last one outgrow it
+// RECORDKEYRATIO times, which bounds the work of a seek
+//
+// a frame holds runs of changed cells against the frame before it, or all
+// cells for a keyframe: varint skip, varint count, then per cell
+// varint (ch << 1 | same pen as the cell before) and unless the same pen
+// varint fg + 1, varint bg + 1, varint attr
+struct record_header {
+  uint32_t magic, version;
+};
+
+struct record_frame {
+  uint64_t ns;
+  uint32_t size; // header and payload, padded to 8 bytes
+  uint16_t rows, cols;
+  uint32_t key, ncells;
+};
+
+struct record_index {
+  uint64_t offset, ns;
+};
+
+struct record_trailer {
+  uint64_t index;
+  uint32_t nindex, magic;
+};
+
+struct record {
+  FILE *file;
+  struct cell *prev;
+  int rows, cols;
+  unsigned char *buf;
+  size_t buf_size, offset, key_size, since_key;
+  struct arena arena; // the index grows in place, for up to RECORDMAXINDEX
+  struct record_index *index;
+  size_t nindex;
+  uint64_t start;
+  unsigned long frames;
+  bool lost; // prev ran ahead of the file, the next frame is a keyframe
+};
+
+// frames are decoded straight from the mapped file into cells
+struct replay {
+  const unsigned char *map;
+  size_t size, end, offset;
+  struct record_index *index;
+  size_t nindex;
+  bool own_index;
+  struct cell *cells;
+  int rows, cols;
+  uint64_t ns, duration;
+  unsigned long frames;
+};
+
+int record_open(struct record *record, const char *path);
+void record_close(struct record *record);
+
+// only the cells that changed are written, nothing when none did
+int record_frame(struct record *record, const struct cell *cells, int rows,
+                 int cols);
+
+// the index is rebuilt by scanning when the recording was cut short
+int replay_open(struct replay *replay, const char *path);
+void replay_close(struct replay *replay);
+
+// 1: cells hold the next frame, 0: end of the recording, -1: corrupt
+int replay_next(struct replay *replay);
+
+// decode from the keyframe before ns up to the last frame at or before ns
+int replay_seek(struct replay *replay, uint64_t ns);
+
+#endif // RECORD_H_
@@ -0,0 +1,584 @@
+/**
+ *  @file   term.c
+ *  @brief  Direct Escape Sequence Output for Ncurses Programs
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "term.h"
+#include "record.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TERMGAP 4
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+#define UPPERHALF L'\u2580'
+#define LOWERHALF L'\u2584'
+#define FULLBLOCK L'\u2588'
+
+static const struct cell blank = {L' ', -1, -1, 0};
+
+static inline bool term_same(const struct cell *a, const struct cell *b) {
+  return (a->ch == b->ch && a->fg == b->fg && a->bg == b->bg &&
+          a->attr == b->attr);
+}
+
+static inline bool term_same_pen(const struct cell *a, const struct cell *b) {
+  return (a->fg == b->fg && a->bg == b->bg && a->attr == b->attr);
+}
+
+static inline int term_digits(int n) {
+  return (n < 10 ? 1 : n < 100 ? 2 : n < 1000 ? 3 : n < 10000 ? 4 : 5);
+}
+
+static inline int term_utf8_size(wchar_t ch) {
+  return (ch < 0x80 ? 1 : ch < 0x800 ? 2 : ch < 0x10000 ? 3 : 4);
+}
+
+static char *term_number(char *p, int n) {
+
+  char digits[12];
+  int i = 0;
+
+  do {
+    digits[i++] = '0' + n % 10;
+    n /= 10;
+  } while (n);
+
+  while (i)
+    *p++ = digits[--i];
+
+  return (p);
+}
+
+// CSI with a single count, which is left out when it is 1
+static char *term_csi(char *p, int n, char final) {
+
+  *p++ = '\33';
+  *p++ = '[';
+  if (n != 1)
+    p = term_number(p, n);
+  *p++ = final;
+
+  return (p);
+}
+
+static inline int term_csi_cost(int n) {
+  return (3 + (n != 1 ? term_digits(n) : 0));
+}
+
+static char *term_utf8(char *p, wchar_t ch) {
+
+  if (ch < 0x80)
+    *p++ = ch;
+  else if (ch < 0x800) {
+    *p++ = 0xc0 | (ch >> 6);
+    *p++ = 0x80 | (ch & 0x3f);
+  } else if (ch < 0x10000) {
+    *p++ = 0xe0 | (ch >> 12);
+    *p++ = 0x80 | ((ch >> 6) & 0x3f);
+    *p++ = 0x80 | (ch & 0x3f);
+  } else {
+    *p++ = 0xf0 | (ch >> 18);
+    *p++ = 0x80 | ((ch >> 12) & 0x3f);
+    *p++ = 0x80 | ((ch >> 6) & 0x3f);
+    *p++ = 0x80 | (ch & 0x3f);
+  }
+
+  return (p);
+}
+
+// cheapest of an absolute address and relative up/down/left/right moves
+static char *term_move(struct term_band *band, char *p, int y, int x) {
+
+  if (band->y == y && band->x == x)
+    return (p);
+
+  int absolute = 3 + term_digits(y + 1) + (x > 0 ? 1 + term_digits(x + 1) : 0);
+
+  if (band->y >= 0 && band->x >= 0) {
+    int dy = y - band->y, dx = x - band->x;
+    int vertical = dy == 0 ? 0 : term_csi_cost(dy > 0 ? dy : -dy),
+        horizontal =
+            dx == 0 ? 0 : dx == -1 ? 1 : term_csi_cost(dx > 0 ? dx : -dx),
+        home = 1 + (x > 0 ? term_csi_cost(x) : 0);
+    bool cr = home < horizontal;
+    int relative = vertical + (cr ? home : horizontal);
+
+    if (dy == 1 && x == 0 && relative >= 2) {
+      *p++ = '\r';
+      *p++ = '\n';
+      band->y = y;
+      band->x = x;
+      return (p);
+    }
+
+    if (relative < absolute) {
+      if (dy > 0)
+        p = term_csi(p, dy, 'B');
+      else if (dy < 0)
+        p = term_csi(p, -dy, 'A');
+      if (cr) {
+        *p++ = '\r';
+        if (x > 0)
+          p = term_csi(p, x, 'C');
+      } else if (dx == -1)
+        *p++ = '\b';
+      else if (dx > 0)
+        p = term_csi(p, dx, 'C');
+      else if (dx < 0)
+        p = term_csi(p, -dx, 'D');
+      band->y = y;
+      band->x = x;
+      return (p);
+    }
+  }
+
+  *p++ = '\33';
+  *p++ = '[';
+  p = term_number(p, y + 1);
+  if (x > 0) {
+    *p++ = ';';
+    p = term_number(p, x + 1);
+  }
+  *p++ = 'H';
+
+  band->y = y;
+  band->x = x;
+
+  return (p);
+}
+
+static char *term_colour(char *p, short colour, int base) {
+
+  if (colour < 0)
+    return (term_number(p, base + 9));
+  if (colour < 8)
+    return (term_number(p, base + colour));
+  if (colour < 16)
+    return (term_number(p, base + 60 + colour - 8));
+
+  p = term_number(p, base + 8);
+  *p++ = ';';
+  *p++ = '5';
+  *p++ = ';';
+  return (term_number(p, colour));
+}
+
+// only what changed since the last cell, a reset when attributes go away
+static char *term_sgr(struct term_band *band, char *p,
+                      const struct cell *cell) {
+
+  static const char codes[] = {'1', '2', '4', '5', '7'};
+  struct cell *sgr = &band->sgr;
+
+  if (term_same_pen(sgr, cell))
+    return (p);
+
+  *p++ = '\33';
+  *p++ = '[';
+  char *params = p;
+
+  if (sgr->attr & ~cell->attr) {
+    *p++ = '0';
+    *sgr = blank;
+  }
+
+  for (size_t i = 0; i < sizeof(codes); i++)
+    if ((cell->attr & ~sgr->attr) & (1 << i)) {
+      if (p != params)
+        *p++ = ';';
+      *p++ = codes[i];
+    }
+
+  if (cell->fg != sgr->fg) {
+    if (p != params)
+      *p++ = ';';
+    p = term_colour(p, cell->fg, 30);
+  }
+
+  if (cell->bg != sgr->bg) {
+    if (p != params)
+      *p++ = ';';
+    p = term_colour(p, cell->bg, 40);
+  }
+
+  *p++ = 'm';
+
+  sgr->fg = cell->fg;
+  sgr->bg = cell->bg;
+  sgr->attr = cell->attr;
+
+  return (p);
+}
+
+// empty buffers are left out by the caller
+static size_t term_write(struct term *term, struct iovec *iov, int n) {
+
+  TRACE("write");
+
+  size_t done = 0;
+
+  while (n > 0) {
+    ssize_t written = writev(term->fd, iov, n < IOV_MAX ? n : IOV_MAX);
+    ++term->writes;
+    if (written == -1) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      break;
+    }
+    done += written;
+    for (; n > 0 && (size_t)written >= iov->iov_len; iov++, n--)
+      written -= iov->iov_len;
+    if (n > 0) {
+      iov->iov_base = (char *)iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  return (done);
+}
+
+// each band gets its rows' worst case and room to reset the pen
+static void term_bands(struct term *term) {
+
+  char *out = term->out;
+
+  for (int i = 0; i < term->nbands; i++) {
+    struct term_band *band = &term->bands[i];
+    band->top = term->rows * i / term->nbands;
+    band->bottom = term->rows * (i + 1) / term->nbands;
+    band->out = out;
+    out += (size_t)(band->bottom - band->top) * term->cols * TERMCELLBYTES +
+           TERMFRAMEBYTES;
+  }
+}
+
+static int term_alloc(struct term *term, int rows, int cols) {
+
+  size_t ncells = (size_t)rows * cols,
+         out_size = ncells * TERMCELLBYTES + term->nbands * TERMFRAMEBYTES;
+
+  struct cell *front =
+      (struct cell *)realloc(term->front, ncells * sizeof(struct cell));
+  if (front == NULL)
+    return (-1);
+  term->front = front;
+
+  struct cell *back =
+      (struct cell *)realloc(term->back, ncells * sizeof(struct cell));
+  if (back == NULL)
+    return (-1);
+  term->back = back;
+
+  short *pixels =
+      (short *)realloc(term->pixels, 2 * ncells * sizeof(short));
+  if (pixels == NULL)
+    return (-1);
+  term->pixels = pixels;
+  for (size_t i = 0; i < 2 * ncells; i++)
+    pixels[i] = -1;
+
+  char *out = (char *)realloc(term->out, out_size);
+  if (out == NULL)
+    return (-1);
+  term->out = out;
+  term->out_size = out_size;
+
+  term->rows = rows;
+  term->cols = cols;
+  term->full = true;
+  term_erase(term);
+  term_bands(term);
+
+  return (0);
+}
+
+int term_init(struct term *term, int fd, int rows, int cols, bool sync) {
+
+  memset(term, 0, sizeof(struct term));
+
+  term->fd = fd;
+  term->sync = sync;
+  term->pen = blank;
+  term->nbands = 1;
+  pool_init(&term->pool, 0);
+
+  if (rows < 1 || cols < 1 || term_alloc(term, rows, cols) == -1) {
+    term_free(term);
+    return (-1);
+  }
+
+  return (0);
+}
+
+void term_free(struct term *term) {
+
+  pool_free(&term->pool);
+  free(term->front);
+  free(term->back);
+  free(term->pixels);
+  free(term->out);
+  term->front = NULL;
+  term->back = NULL;
+  term->pixels = NULL;
+  term->out = NULL;
+}
+
+int term_threads(struct term *term, int nthreads) {
+
+  if (nthreads < 0 || nthreads >= TERMMAXBANDS)
+    return (-1);
+
+  // without workers every band is encoded by the caller
+  pool_free(&term->pool);
+  if (pool_init(&term->pool, nthreads) == -1) {
+    pool_init(&term->pool, 0);
+    return (-1);
+  }
+
+  term->nbands = nthreads + 1;
+
+  return (term_alloc(term, term->rows, term->cols));
+}
+
+int term_resize(struct term *term, int rows, int cols) {
+
+  if (rows < 1 || cols < 1)
+    return (-1);
+
+  return (term_alloc(term, rows, cols));
+}
+
+void term_pen(struct term *term, short fg, short bg, unsigned short attr) {
+
+  term->pen.fg = fg;
+  term->pen.bg = bg;
+  term->pen.attr = attr;
+}
+
+void term_erase(struct term *term) {
+
+  size_t ncells = (size_t)term->rows * term->cols;
+
+  for (size_t i = 0; i < ncells; i++)
+    term->back[i] = blank;
+}
+
+void term_addwstr(struct term *term, int y, int x, const wchar_t *str) {
+
+  while (*str)
+    term_put(term, y, x++, *str++);
+}
+
+void term_printw(struct term *term, int y, int x, const char *fmt, ...) {
+
+  char buf[256];
+  va_list args;
+
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  for (int i = 0; i < len && i < (int)sizeof(buf) - 1; i++)
+    term_put(term, y, x++, (unsigned char)buf[i]);
+}
+
+// the colours a cell shows in its top and bottom half
+static bool term_halves(const struct cell *cell, short *top, short *bottom) {
+
+  if (cell->attr)
+    return (false);
+
+  switch (cell->ch) {
+  case L' ':
+    *top = *bottom = cell->bg;
+    return (true);
+  case FULLBLOCK:
+    *top = *bottom = cell->fg;
+    return (cell->fg >= 0);
+  case UPPERHALF:
+    *top = cell->fg;
+    *bottom = cell->bg;
+    return (cell->fg >= 0);
+  case LOWERHALF:
+    *top = cell->bg;
+    *bottom = cell->fg;
+    return (cell->fg >= 0);
+  }
+
+  return (false);
+}
+
+static inline int term_pen_cost(const struct cell *cell,
+                                const struct cell *prev) {
+  return ((cell->fg != prev->fg) + (cell->bg != prev->bg));
+}
+
+// a band starts from the default pen, so it does not depend on the one above
+static void term_halfband(void *arg, int i) {
+
+  struct term *term = (struct term *)arg;
+  const struct term_band *band = &term->bands[i];
+  const struct cell *prev = &blank;
+  int cols = term->cols;
+
+  for (int y = band->top; y < band->bottom; y++) {
+    const short *upper = term->pixels + 2 * y * cols, *lower = upper + cols;
+    for (int x = 0; x < cols; x++) {
+      struct cell *cell = &term->back[y * cols + x],
+                  *front = &term->front[y * cols + x];
+      short top = upper[x], bottom = lower[x], shown_top, shown_bottom;
+
+      // whatever the terminal shows already is free
+      if (!term->full && term_halves(front, &shown_top, &shown_bottom) &&
+          shown_top == top && shown_bottom == bottom) {
+        *cell = *front;
+        prev = cell;
+        continue;
+      }
+
+      // pick the glyph that keeps the pen of the run going, the colour a
+      // glyph does not show is taken from the previous cell
+      struct cell a, b;
+      if (top == bottom) {
+        a = (struct cell){L' ', prev->fg, top, 0};
+        b = (struct cell){FULLBLOCK, top, prev->bg, 0};
+      } else {
+        a = (struct cell){UPPERHALF, top, bottom, 0};
+        b = (struct cell){LOWERHALF, bottom, top, 0};
+      }
+
+      if (a.fg < 0 && a.ch != L' ')
+        *cell = b;
+      else if (b.fg < 0 || term_pen_cost(&a, prev) <= term_pen_cost(&b, prev))
+        *cell = a;
+      else
+        *cell = b;
+
+      prev = cell;
+    }
+  }
+}
+
+void term_halfblocks(struct term *term) {
+  pool_run(&term->pool, term_halfband, term, term->nbands);
+}
+
+// the first band carries on from the last frame, the others start from an
+// unknown cursor; every band ends in the default pen
+static void term_encode(void *arg, int i) {
+
+  TRACE("encode");
+
+  struct term *term = (struct term *)arg;
+  struct term_band *band = &term->bands[i];
+  char *p = band->out;
+  int cols = term->cols;
+
+  band->y = i == 0 ? term->y : -1;
+  band->x = i == 0 ? term->x : -1;
+  band->sgr = blank;
+  band->cells = 0;
+
+  for (int y = band->top; y < band->bottom; y++) {
+    struct cell *back = term->back + y * cols, *front = term->front + y * cols;
+    for (int x = 0; x < cols; x++) {
+      if (term_same(&back[x], &front[x]))
+        continue;
+
+      // a few unchanged cells in the current pen are cheaper to repeat
+      if (band->y == y && band->x >= 0 && band->x < x &&
+          x - band->x <= TERMGAP) {
+        int bytes = 0, gap = band->x;
+        for (int g = gap; g < x && bytes >= 0; g++)
+          bytes = term_same_pen(&back[g], &band->sgr)
+                      ? bytes + term_utf8_size(back[g].ch)
+                      : -1;
+        if (bytes >= 0 && bytes < term_csi_cost(x - gap)) {
+          for (int g = gap; g < x; g++)
+            p = term_utf8(p, back[g].ch);
+          band->x = x;
+        }
+      }
+
+      p = term_move(band, p, y, x);
+      p = term_sgr(band, p, &back[x]);
+      p = term_utf8(p, back[x].ch);
+      front[x] = back[x];
+      ++band->cells;
+
+      // the column is uncertain after writing into the last one
+      if (++band->x == cols)
+        band->y = band->x = -1;
+    }
+  }
+
+  // leave the default pen for the next band and ncurses
+  if (!term_same_pen(&band->sgr, &blank)) {
+    p = stpcpy(p, "\33[m");
+    band->sgr = blank;
+  }
+
+  band->end = p;
+}
+
+size_t term_frame(struct term *term) {
+
+  static char sync_on[] = "\33[?2026h", sync_off[] = "\33[?2026l",
+              clear[] = "\33[0m\33[H\33[2J";
+  struct iovec *iov = term->iov;
+  int n = 0;
+
+  if (term->record != NULL)
+    record_frame(term->record, term->back, term->rows, term->cols);
+
+  term->cells = term->writes = 0;
+
+  if (term->sync)
+    iov[n++] = (struct iovec){sync_on, sizeof(sync_on) - 1};
+
+  int start = n;
+
+  // repaint from a cleared screen, the blanks then need not be sent
+  if (term->full) {
+    iov[n++] = (struct iovec){clear, sizeof(clear) - 1};
+    for (size_t i = 0; i < (size_t)term->rows * term->cols; i++)
+      term->front[i] = blank;
+    term->y = term->x = 0;
+    term->full = false;
+  }
+
+  pool_run(&term->pool, term_encode, term, term->nbands);
+
+  for (int i = 0; i < term->nbands; i++) {
+    struct term_band *band = &term->bands[i];
+    if (band->end == band->out)
+      continue;
+    iov[n++] = (struct iovec){band->out, band->end - band->out};
+    term->cells += band->cells;
+    term->y = band->y;
+    term->x = band->x;
+  }
+
+  if (n == start)
+    return (0);
+
+  if (term->sync)
+    iov[n++] = (struct iovec){sync_off, sizeof(sync_off) - 1};
+
+  return (term_write(term, iov, n));
+}
@@ -0,0 +1,108 @@
+/**
+ *  @file   term.h
+ *  @brief  Direct Escape Sequence Output for Ncurses Programs
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef TERM_H_
+#define TERM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include <wchar.h>
+
+#include "pool.h"
+
+// worst case bytes per changed cell: cursor address, SGR and UTF-8
+#define TERMCELLBYTES 64
+#define TERMFRAMEBYTES 64
+#define TERMMAXBANDS 64
+
+#define TERM_BOLD 1
+#define TERM_DIM 2
+#define TERM_UNDERLINE 4
+#define TERM_BLINK 8
+#define TERM_REVERSE 16
+
+// colours are xterm palette indices, -1 is the terminal default
+struct cell {
+  wchar_t ch;
+  short fg, bg;
+  unsigned short attr;
+};
+
+struct record;
+
+// rows [top, bottom) encoded into their own stretch of out, the cursor and
+// pen are where the band left them
+struct term_band {
+  int top, bottom, y, x;
+  struct cell sgr;
+  char *out, *end;
+  unsigned long cells;
+};
+
+// cells are one column wide; back is drawn into, front is what the terminal
+// shows, term_frame sends the difference; pixels stack two to a cell
+struct term {
+  int fd, rows, cols;
+  struct cell *front, *back, pen;
+  short *pixels;
+  struct record *record;
+  char *out;
+  size_t out_size;
+  int y, x;
+  bool sync, full;
+  struct pool pool;
+  struct term_band bands[TERMMAXBANDS];
+  struct iovec iov[TERMMAXBANDS + 3]; // sync on, clear, bands, sync off
+  int nbands;
+  unsigned long cells, writes; // sent by the last term_frame
+};
+
+int term_init(struct term *term, int fd, int rows, int cols, bool sync);
+void term_free(struct term *term);
+
+// split the frame in nthreads + 1 row bands, diffed and encoded in parallel
+// by nthreads workers and the caller, and sent with a single writev
+int term_threads(struct term *term, int nthreads);
+
+// new size, the next frame repaints every cell
+int term_resize(struct term *term, int rows, int cols);
+
+void term_pen(struct term *term, short fg, short bg, unsigned short attr);
+void term_erase(struct term *term);
+void term_addwstr(struct term *term, int y, int x, const wchar_t *str);
+void term_printw(struct term *term, int y, int x, const char *fmt, ...);
+
+// turn the pixels into half blocks on back, text can be drawn over them
+void term_halfblocks(struct term *term);
+
+// encode the changes and write them, returns bytes written; the frame is
+// also added to term->record when set
+size_t term_frame(struct term *term);
+
+static inline void term_put(struct term *term, int y, int x, wchar_t ch) {
+
+  if (y < 0 || y >= term->rows || x < 0 || x >= term->cols)
+    return;
+
+  struct cell *cell = &term->back[y * term->cols + x];
+  *cell = term->pen;
+  cell->ch = ch;
+}
+
+// pixel rows are twice the cell rows, colour -1 is the default background
+static inline void term_plot(struct term *term, int y, int x, short colour) {
+
+  if (y < 0 || y >= 2 * term->rows || x < 0 || x >= term->cols)
+    return;
+
+  term->pixels[y * term->cols + x] = colour;
+}
+
+#endif // TERM_H_
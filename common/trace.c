@@ -0,0 +1,158 @@
+/**
+ *  @file   trace.c
+ *  @brief  Per-Thread Event Tracing in the Chrome Trace Format
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "trace.h"
+#include "arena.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+struct trace_event {
+  const char *name;
+  uint64_t start, stop;
+};
+
+// written by its thread only, read once all threads are done; only the
+// last TRACEEVENTS events are kept
+struct trace_buffer {
+  struct arena arena;
+  struct trace_event *events;
+  size_t n;
+  const char *name;
+};
+
+bool trace_on = false;
+
+static struct trace_buffer buffers[TRACETHREADS];
+static int nbuffers, fd = -1;
+static uint64_t origin;
+static __thread struct trace_buffer *mine;
+
+// the address space comes from mmap, so a thread's first event never
+// allocates from the heap
+static struct trace_buffer *trace_buffer(void) {
+
+  if (mine != NULL)
+    return (mine);
+
+  int i = __atomic_fetch_add(&nbuffers, 1, __ATOMIC_RELAXED);
+  if (i >= TRACETHREADS)
+    return (NULL);
+
+  struct trace_buffer *buffer = &buffers[i];
+  if (arena_init(&buffer->arena, TRACEEVENTS * sizeof(struct trace_event)) ==
+      -1)
+    return (NULL);
+  buffer->events = (struct trace_event *)arena_alloc(
+      &buffer->arena, TRACEEVENTS * sizeof(struct trace_event));
+
+  return (mine = buffer);
+}
+
+int trace_open(const char *path) {
+
+  if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+    return (-1);
+
+  origin = trace_now();
+  trace_on = true;
+  trace_thread("main");
+
+  return (0);
+}
+
+void trace_thread(const char *name) {
+
+  struct trace_buffer *buffer;
+
+  if (trace_on && (buffer = trace_buffer()) != NULL)
+    buffer->name = name;
+}
+
+void trace_record(const char *name, uint64_t start, uint64_t stop) {
+
+  struct trace_buffer *buffer;
+
+  if (!trace_on || (buffer = trace_buffer()) == NULL)
+    return;
+
+  buffer->events[buffer->n++ & (TRACEEVENTS - 1)] =
+      (struct trace_event){name, start, stop};
+}
+
+// snprintf into a fixed buffer and plain writes, so closing allocates
+// nothing either
+static void trace_flush(char *out, int *len, bool force) {
+
+  if (*len > 0 && (force || *len > 3072)) {
+    write(fd, out, *len);
+    *len = 0;
+  }
+}
+
+void trace_close(void) {
+
+  char out[4096];
+  int len = 0, pid = getpid(), n = nbuffers < TRACETHREADS ? nbuffers
+                                                           : TRACETHREADS;
+  bool first = true;
+
+  if (fd == -1)
+    return;
+
+  trace_on = false;
+
+  len += snprintf(out + len, sizeof(out) - len,
+                  "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+  for (int tid = 0; tid < n; tid++) {
+    struct trace_buffer *buffer = &buffers[tid];
+    if (buffer->name != NULL) {
+      len += snprintf(out + len, sizeof(out) - len,
+                      "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+                      "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                      first ? "" : ",", pid, tid, buffer->name);
+      first = false;
+    }
+    size_t i = buffer->n > TRACEEVENTS ? buffer->n - TRACEEVENTS : 0;
+    if (i > 0) {
+      len += snprintf(
+          out + len, sizeof(out) - len,
+          "%s\n{\"name\":\"%zu earlier events dropped\",\"ph\":\"i\","
+          "\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f}",
+          first ? "" : ",", i, pid, tid,
+          (buffer->events[i & (TRACEEVENTS - 1)].start - origin) / 1e3);
+      first = false;
+    }
+    for (; i < buffer->n; i++) {
+      struct trace_event *event = &buffer->events[i & (TRACEEVENTS - 1)];
+      len += snprintf(out + len, sizeof(out) - len,
+                      "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,"
+                      "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                      first ? "" : ",", event->name, pid, tid,
+                      (event->start - origin) / 1e3,
+                      (event->stop - event->start) / 1e3);
+      first = false;
+      trace_flush(out, &len, false);
+    }
+    trace_flush(out, &len, false);
+  }
+
+  len += snprintf(out + len, sizeof(out) - len, "\n]}\n");
+  trace_flush(out, &len, true);
+
+  close(fd);
+  fd = -1;
+
+  for (int i = 0; i < n; i++)
+    arena_free(&buffers[i].arena);
+  nbuffers = 0;
+}
@@ -0,0 +1,81 @@
+/**
+ *  @file   trace.h
+ *  @brief  Per-Thread Event Tracing in the Chrome Trace Format
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#define TRACEEVENTS (1 << 18) // per thread, a power of two
+#define TRACETHREADS 64
+
+// names are string literals, they are kept as pointers
+struct trace_scope {
+  const char *name;
+  uint64_t start;
+};
+
+extern bool trace_on;
+
+// tracing is off until opened; the file is written on close, once every
+// traced thread is done
+int trace_open(const char *path);
+void trace_close(void);
+
+// names the calling thread in the trace
+void trace_thread(const char *name);
+
+void trace_record(const char *name, uint64_t start, uint64_t stop);
+
+static inline uint64_t trace_now(void) {
+
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+// a span between two readings of CLOCK_MONOTONIC in ns, such as those
+// taken for the metrics already
+static inline void trace_span(const char *name, uint64_t start,
+                              uint64_t stop) {
+
+  if (trace_on)
+    trace_record(name, start, stop);
+}
+
+// off, a scope costs a load and a branch on either end
+static inline struct trace_scope trace_begin(const char *name) {
+
+  struct trace_scope scope = {name, 0};
+
+  if (trace_on)
+    scope.start = trace_now();
+
+  return (scope);
+}
+
+static inline void trace_end(struct trace_scope *scope) {
+
+  if (scope->start)
+    trace_record(scope->name, scope->start, trace_now());
+}
+
+#define TRACE_CAT(a, b) a##b
+#define TRACE_NAME(line) TRACE_CAT(trace_scope_, line)
+
+// traces the rest of the enclosing block
+#define TRACE(name)                                                            \
+  struct trace_scope TRACE_NAME(__LINE__)                                      \
+      __attribute__((cleanup(trace_end))) = trace_begin(name)
+
+#endif // TRACE_H_
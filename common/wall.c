@@ -0,0 +1,223 @@
+/**
+ *  @file   wall.c
+ *  @brief  One Canvas Shown on Several Terminals
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "wall.h"
+#include "record.h"
+#include "trace.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+static const char hide[] = "\33[?25l", show[] = "\33[0m\33[H\33[2J\33[?25h";
+
+static void *wall_output(void *arg) {
+
+  struct wall_view *view = (struct wall_view *)arg;
+  struct wall *wall = view->wall;
+
+  // started before the first frame, which must not be missed
+  unsigned long seen = 0;
+
+  trace_thread("wall");
+
+  pthread_mutex_lock(&wall->lock);
+
+  while (true) {
+    while (!wall->quit && wall->generation == seen)
+      pthread_cond_wait(&wall->start, &wall->lock);
+    if (wall->quit)
+      break;
+    seen = wall->generation;
+    pthread_mutex_unlock(&wall->lock);
+    view->bytes = term_frame(&view->term);
+    pthread_mutex_lock(&wall->lock);
+    if (--wall->busy == 0)
+      pthread_cond_signal(&wall->done);
+  }
+
+  pthread_mutex_unlock(&wall->lock);
+
+  return (NULL);
+}
+
+// with the lock held
+static void wall_wait(struct wall *wall) {
+
+  while (wall->busy > 0)
+    pthread_cond_wait(&wall->done, &wall->lock);
+}
+
+static int wall_view(struct wall *wall, int fd, bool tty, int rows, int cols,
+                     bool sync) {
+
+  struct wall_view *view = &wall->views[wall->nviews];
+
+  if (term_init(&view->term, fd, rows, cols, sync) == -1)
+    return (-1);
+
+  view->wall = wall;
+  view->tty = tty;
+  view->bytes = 0;
+  view->y = view->x = 0;
+  ++wall->nviews;
+
+  return (0);
+}
+
+int wall_open(struct wall *wall, char **ttys, int nttys, int tiles, int rows,
+              int cols, bool sync) {
+
+  memset(wall, 0, sizeof(struct wall));
+
+  pthread_mutex_init(&wall->lock, NULL);
+  pthread_cond_init(&wall->start, NULL);
+  pthread_cond_init(&wall->done, NULL);
+
+  if (nttys < 1 || nttys > WALLMAX ||
+      wall_view(wall, STDOUT_FILENO, false, rows, cols, sync) == -1) {
+    wall_close(wall);
+    return (-1);
+  }
+
+  // the smallest tty sets the size of a tile
+  int tile_rows = 0, tile_cols = 0;
+
+  for (int i = 0; i < nttys; i++) {
+    struct winsize ws;
+    int fd = open(ttys[i], O_WRONLY | O_NOCTTY);
+    if (fd == -1 || ioctl(fd, TIOCGWINSZ, &ws) == -1 || ws.ws_row < 1 ||
+        ws.ws_col < 1 || wall_view(wall, fd, true, ws.ws_row, ws.ws_col,
+                                   sync) == -1) {
+      if (fd != -1)
+        close(fd);
+      wall_close(wall);
+      return (-1);
+    }
+    write(fd, hide, sizeof(hide) - 1);
+    if (tile_rows == 0 || ws.ws_row < tile_rows)
+      tile_rows = ws.ws_row;
+    if (tile_cols == 0 || ws.ws_col < tile_cols)
+      tile_cols = ws.ws_col;
+  }
+
+  if (tiles > 0) {
+    if (tiles > nttys)
+      tiles = nttys;
+    for (int i = 0; i < nttys; i++) {
+      wall->views[i + 1].y = i / tiles * tile_rows;
+      wall->views[i + 1].x = i % tiles * tile_cols;
+    }
+    wall->rows = (nttys + tiles - 1) / tiles * tile_rows;
+    wall->cols = tiles * tile_cols;
+  } else {
+    wall->rows = tile_rows;
+    wall->cols = tile_cols;
+  }
+
+  // signals, SIGWINCH in particular, are left to the main thread
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  for (; wall->nthreads < wall->nviews; wall->nthreads++)
+    if (pthread_create(&wall->views[wall->nthreads].thread, NULL,
+                       wall_output, &wall->views[wall->nthreads]) != 0)
+      break;
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (wall->nthreads < wall->nviews) {
+    wall_close(wall);
+    return (-1);
+  }
+
+  return (0);
+}
+
+void wall_close(struct wall *wall) {
+
+  pthread_mutex_lock(&wall->lock);
+  wall_wait(wall);
+  wall->quit = true;
+  pthread_cond_broadcast(&wall->start);
+  pthread_mutex_unlock(&wall->lock);
+
+  for (int i = 0; i < wall->nthreads; i++)
+    pthread_join(wall->views[i].thread, NULL);
+  wall->nthreads = 0;
+
+  for (int i = 0; i < wall->nviews; i++) {
+    struct wall_view *view = &wall->views[i];
+    if (view->tty) {
+      write(view->term.fd, show, sizeof(show) - 1);
+      close(view->term.fd);
+    }
+    term_free(&view->term);
+  }
+  wall->nviews = 0;
+
+  pthread_mutex_destroy(&wall->lock);
+  pthread_cond_destroy(&wall->start);
+  pthread_cond_destroy(&wall->done);
+}
+
+int wall_resize(struct wall *wall, int rows, int cols) {
+
+  pthread_mutex_lock(&wall->lock);
+  wall_wait(wall);
+  pthread_mutex_unlock(&wall->lock);
+
+  return (term_resize(&wall->views[0].term, rows, cols));
+}
+
+size_t wall_frame(struct wall *wall, struct term *canvas) {
+
+  size_t bytes = 0;
+
+  pthread_mutex_lock(&wall->lock);
+
+  wall_wait(wall);
+
+  canvas->cells = canvas->writes = 0;
+
+  for (int i = 0; i < wall->nviews; i++) {
+    struct wall_view *view = &wall->views[i];
+    bytes += view->bytes;
+    canvas->cells += view->term.cells;
+    canvas->writes += view->term.writes;
+  }
+
+  if (canvas->record != NULL)
+    record_frame(canvas->record, canvas->back, canvas->rows, canvas->cols);
+
+  // views reaching past the canvas show blanks there
+  for (int i = 0; i < wall->nviews; i++) {
+    struct term *term = &wall->views[i].term;
+    int y0 = wall->views[i].y, x0 = wall->views[i].x,
+        rows = canvas->rows - y0 < term->rows ? canvas->rows - y0 : term->rows,
+        cols = canvas->cols - x0 < term->cols ? canvas->cols - x0 : term->cols;
+    if (rows < term->rows || cols < term->cols)
+      term_erase(term);
+    for (int y = 0; y < rows; y++)
+      memcpy(term->back + y * term->cols,
+             canvas->back + (y0 + y) * canvas->cols + x0,
+             cols * sizeof(struct cell));
+  }
+
+  ++wall->generation;
+  wall->busy = wall->nviews;
+  pthread_cond_broadcast(&wall->start);
+
+  pthread_mutex_unlock(&wall->lock);
+
+  return (bytes);
+}
@@ -0,0 +1,60 @@
+/**
+ *  @file   wall.h
+ *  @brief  One Canvas Shown on Several Terminals
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef WALL_H_
+#define WALL_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "term.h"
+
+#define WALLMAX 16
+
+struct wall;
+
+// a region of the canvas at y, x, sent to its terminal by its own thread
+struct wall_view {
+  struct wall *wall;
+  struct term term;
+  int y, x;
+  bool tty; // opened by the wall, restored on close
+  pthread_t thread;
+  size_t bytes;
+};
+
+// the local terminal is the first view, its region starts at the origin
+struct wall {
+  int rows, cols;
+  struct wall_view views[WALLMAX + 1];
+  int nviews;
+  pthread_mutex_t lock;
+  pthread_cond_t start, done;
+  unsigned long generation;
+  int busy, nthreads;
+  bool quit;
+};
+
+// tiles > 0 lays the ttys out in rows of tiles, each the size of the smallest
+// tty, on a canvas they cover together; 0 mirrors a canvas of the smallest
+// tty on all of them; rows and cols are the local terminal's
+int wall_open(struct wall *wall, char **ttys, int nttys, int tiles, int rows,
+              int cols, bool sync);
+void wall_close(struct wall *wall);
+
+// only the local view follows the local terminal, the canvas stays
+int wall_resize(struct wall *wall, int rows, int cols);
+
+// waits for the last frame to go out, hands every view its region of the
+// canvas and returns the bytes of the last frame, whose cells and writes go
+// to those of the canvas; the frame is also added to canvas->record when set
+size_t wall_frame(struct wall *wall, struct term *canvas);
+
+#endif // WALL_H_
@@ -1,8 +1,16 @@
 #include <locale.h>
 #include <ncurses.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
+
+#include "allocguard.h"
+#include "metrics.h"
+#include "record.h"
+#include "term.h"
+#include "trace.h"
 
 enum colors {
   BLACK,
@@ -17,8 +25,26 @@ enum colors {
   NCOLORS
 };
 
+// https://jonasjacek.github.io/colors/
+static const short ColorNum[] = {0, 15, 1, 10, 12, 7, 4, 2, 3};
+
+struct term *pTerm = NULL;
+
+bool bHalf = false;
+
 void draw(int x, int y, int color) {
 
+  if (bHalf) {
+    term_plot(pTerm, y, x, ColorNum[color]);
+    return;
+  }
+
+  if (pTerm) {
+    term_pen(pTerm, ColorNum[color], -1, 0);
+    term_put(pTerm, y, x, L'\u2588');
+    return;
+  }
+
   attron(COLOR_PAIR(color));
 
   mvprintw(y, x, "%lc", L'\u2588');
@@ -30,13 +56,75 @@ int main(int argc, char *argv[], char **envp) {
 
   int nX = 0, nY = 0, nXmax = 0, nYmax = 0, nKey;
 
-  float fMicroSeconds = 0.0f;
-
   float fCarPos = 0.0f;
 
-  struct timespec sStartTimespec, sStopTimespec;
+  uint64_t nStart = 0, nStop, nUpdated, nComposed, nOutput, nInput, nFrameNs;
+
+  bool bFinished = false, bPaused = false, bSync = false;
+
+  struct term sTerm;
+
+  struct record sRecord;
+
+  char *pRecordFile = NULL, *pMetricsTarget = NULL, *pTraceFile = NULL;
+
+  struct metrics sMetrics;
+
+  int nOpt;
+
+  while ((nOpt = getopt(argc, argv, "de:R:rST:")) != -1) {
+    switch (nOpt) {
+    case 'd':
+      bHalf = true;
+      pTerm = &sTerm;
+      break;
+    case 'e':
+      pMetricsTarget = optarg;
+      break;
+    case 'R':
+      pRecordFile = optarg;
+      pTerm = &sTerm;
+      break;
+    case 'S':
+      bSync = true;
+      pTerm = &sTerm;
+      break;
+    case 'r':
+      pTerm = &sTerm;
+      break;
+    case 'T':
+      pTraceFile = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-d] [-e target] [-r] [-R file] [-S] [-T file]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (pRecordFile && record_open(&sRecord, pRecordFile) == -1) {
+    fprintf(stderr, "unable to record to %s\n", pRecordFile);
+    return 1;
+  }
+
+  if (metrics_init(&sMetrics, "gp", pMetricsTarget) == -1) {
+    fprintf(stderr, "unable to export metrics to %s\n", pMetricsTarget);
+    return 1;
+  }
 
-  bool bFinished = false, bPaused = false;
+  if (pTraceFile && trace_open(pTraceFile) == -1) {
+    fprintf(stderr, "unable to trace to %s\n", pTraceFile);
+    return 1;
+  }
+
+  int nFrameMetric = metrics_histogram(&sMetrics, "frame_ns", true),
+      nUpdateMetric = metrics_histogram(&sMetrics, "update_ns", true),
+      nOutputMetric = metrics_histogram(&sMetrics, "output_ns", true),
+      nInputMetric = metrics_histogram(&sMetrics, "input_ns", true),
+      nCellsMetric = metrics_histogram(&sMetrics, "cells", false),
+      nBytesMetric = metrics_histogram(&sMetrics, "bytes", false),
+      nWritesMetric = metrics_counter(&sMetrics, "writes");
 
   setlocale(LC_ALL, "");
 
@@ -46,24 +134,8 @@ int main(int argc, char *argv[], char **envp) {
 
   use_default_colors();
 
-  // https://jonasjacek.github.io/colors/
-  init_pair(BLACK, 0, -1);
-
-  init_pair(WHITE, 15, -1);
-
-  init_pair(RED, 1, -1);
-
-  init_pair(GREEN, 10, -1);
-
-  init_pair(BLUE, 12, -1);
-
-  init_pair(GRAY, 7, -1);
-
-  init_pair(DARKBLUE, 4, -1);
-
-  init_pair(DARKGREEN, 2, -1);
-
-  init_pair(BROWN, 3, -1);
+  for (short i = BLACK; i < NCOLORS; i++)
+    init_pair(i, ColorNum[i], -1);
 
   noecho();
 
@@ -75,11 +147,24 @@ int main(int argc, char *argv[], char **envp) {
 
   getmaxyx(stdscr, nYmax, nXmax);
 
+  // ncurses keeps the input, frames bypass it
+  if (pTerm) {
+    refresh();
+    if (term_init(pTerm, STDOUT_FILENO, nYmax, nXmax, bSync) == -1) {
+      pTerm = NULL;
+      bHalf = false;
+    } else if (pRecordFile)
+      pTerm->record = &sRecord;
+  }
+
   wchar_t pixels[] = {L' ', L'\u2591', L'\u2592', L'\u2593', L'\u2588'};
 
   while (!bFinished) {
 
-    clock_gettime(CLOCK_MONOTONIC_RAW, &sStopTimespec);
+    nStop = metrics_now();
+
+    if (nKey == 'h')
+      sMetrics.hud = !sMetrics.hud;
 
     if (nKey == 'p')
       bPaused = !bPaused;
@@ -87,16 +172,27 @@ int main(int argc, char *argv[], char **envp) {
     if (nKey == 'q')
       bFinished = true;
 
-    if (nKey == KEY_RESIZE)
+    if (nKey == KEY_RESIZE) {
       getmaxyx(stdscr, nYmax, nXmax);
+      if (pTerm) {
+        refresh();
+        term_resize(pTerm, nYmax, nXmax);
+      }
+    }
 
     if (!bPaused) {
 
-      erase();
+      if (pTerm)
+        term_erase(pTerm);
+      else
+        erase();
+
+      // half blocks give two pixels per row
+      int nYpixels = bHalf ? 2 * nYmax : nYmax;
 
       for (int x = 0; x < nXmax; x++) {
 
-        for (int y = 0; y < nYmax / 2; y++) {
+        for (int y = 0; y < nYpixels / 2; y++) {
 
           draw(x, y, DARKBLUE);
 
@@ -106,7 +202,7 @@ int main(int argc, char *argv[], char **envp) {
 
           float fClipWidth = fRoadWidth * 0.15f;
 
-          int nRow = nYmax / 2 + y;
+          int nRow = nYpixels / 2 + y;
 
           fRoadWidth *= 0.5f;
 
@@ -128,34 +224,101 @@ int main(int argc, char *argv[], char **envp) {
         }
       }
 
+      if (bHalf)
+        term_halfblocks(pTerm);
+
       int nCarPosX = nXmax / 2 + ((int)nXmax * fCarPos / 2.0f) - 7;
       int nCarPosY = nYmax - 8;
 
       // attron( COLOR_PAIR( BLACK ) );
 
-      mvaddwstr(nCarPosY++, nCarPosX + 2, L"||####||");
-      mvaddwstr(nCarPosY++, nCarPosX + 5, L"##");
-      mvaddwstr(nCarPosY++, nCarPosX + 4, L"####");
-      mvaddwstr(nCarPosY++, nCarPosX + 4, L"####");
-      mvaddwstr(nCarPosY++, nCarPosX + 0, L"||| #### |||");
-      mvaddwstr(nCarPosY++, nCarPosX + 0, L"|||######|||");
-      mvaddwstr(nCarPosY, nCarPosX + 0, L"||| #### |||");
+      if (pTerm) {
+        term_pen(pTerm, -1, -1, 0);
+        term_addwstr(pTerm, nCarPosY++, nCarPosX + 2, L"||####||");
+        term_addwstr(pTerm, nCarPosY++, nCarPosX + 5, L"##");
+        term_addwstr(pTerm, nCarPosY++, nCarPosX + 4, L"####");
+        term_addwstr(pTerm, nCarPosY++, nCarPosX + 4, L"####");
+        term_addwstr(pTerm, nCarPosY++, nCarPosX + 0, L"||| #### |||");
+        term_addwstr(pTerm, nCarPosY++, nCarPosX + 0, L"|||######|||");
+        term_addwstr(pTerm, nCarPosY, nCarPosX + 0, L"||| #### |||");
+      } else {
+        mvaddwstr(nCarPosY++, nCarPosX + 2, L"||####||");
+        mvaddwstr(nCarPosY++, nCarPosX + 5, L"##");
+        mvaddwstr(nCarPosY++, nCarPosX + 4, L"####");
+        mvaddwstr(nCarPosY++, nCarPosX + 4, L"####");
+        mvaddwstr(nCarPosY++, nCarPosX + 0, L"||| #### |||");
+        mvaddwstr(nCarPosY++, nCarPosX + 0, L"|||######|||");
+        mvaddwstr(nCarPosY, nCarPosX + 0, L"||| #### |||");
+      }
 
       // attroff( COLOR_PAIR( BLACK ) );
     }
 
-    fMicroSeconds =
-        (float)(sStopTimespec.tv_sec - sStartTimespec.tv_sec) * 1000000.0f +
-        (float)(sStopTimespec.tv_nsec - sStartTimespec.tv_nsec) / 1000.0f;
+    nUpdated = metrics_now();
+
+    nFrameNs = nStart ? nStop - nStart : 0;
+
+    if (pTerm) {
+      term_pen(pTerm, -1, -1, 0);
+      term_printw(pTerm, nYmax - 1, 0, "FPS: %0.2f",
+                  nFrameNs ? 1e9 / nFrameNs : 0.0);
+    } else
+      mvprintw(nYmax - 1, 0, "FPS: %0.2f", nFrameNs ? 1e9 / nFrameNs : 0.0);
+
+    if (sMetrics.hud) {
+      char sLine[METRICSLINE];
+      for (int i = 0; metrics_hud(&sMetrics, i, sLine, METRICSLINE); i++)
+        if (pTerm)
+          term_printw(pTerm, i, 0, "%s", sLine);
+        else
+          mvprintw(i, 0, "%s", sLine);
+    }
+
+    nComposed = metrics_now();
+
+    if (pTerm) {
+      metrics_observe(&sMetrics, nBytesMetric, term_frame(pTerm));
+      metrics_observe(&sMetrics, nCellsMetric, pTerm->cells);
+      metrics_add(&sMetrics, nWritesMetric, pTerm->writes);
+    } else
+      refresh();
+
+    nOutput = metrics_now();
+
+    nKey = getch();
+
+    nInput = metrics_now();
 
-    mvprintw(nYmax - 1, 0, "FPS: %0.2f", 1000000.0f / fMicroSeconds);
+    allocguard_frame();
 
-    nKey = getch(); // calls refresh
+    if (nFrameNs)
+      metrics_observe(&sMetrics, nFrameMetric, nFrameNs);
+    metrics_observe(&sMetrics, nUpdateMetric, nUpdated - nStop);
+    metrics_observe(&sMetrics, nOutputMetric, nOutput - nUpdated);
+    metrics_observe(&sMetrics, nInputMetric, nInput - nOutput);
 
-    sStartTimespec = sStopTimespec;
+    trace_span("simulate", nStop, nUpdated);
+    trace_span("compose", nUpdated, nComposed);
+    trace_span("flush", nComposed, nOutput);
+    trace_span("input", nOutput, nInput);
+
+    metrics_tick(&sMetrics, nStop);
+
+    nStart = nStop;
   }
 
   endwin();
 
+  if (pTerm)
+    term_free(pTerm);
+
+  if (pRecordFile)
+    record_close(&sRecord);
+
+  metrics_free(&sMetrics);
+
+  if (pTraceFile)
+    trace_close();
+
   return 0;
 }
@@ -9,12 +9,27 @@
 
 #include <locale.h>
 #include <ncurses.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "allocguard.h"
+#include "arena.h"
+#include "metrics.h"
+#include "palette.h"
+#include "record.h"
+#include "term.h"
+#include "trace.h"
+#include "wall.h"
+#include "wheel.h"
+
+#define ARENASIZE (64 << 20)
+#define MUTATIONS 2 // glyphs changing at a time per streamer
+
 struct sStreamer {
   size_t nXpos;
   float fYpos;
@@ -23,6 +38,12 @@ struct sStreamer {
   wchar_t *sChars;
 };
 
+// the katakana of the mtx font
+wchar_t streamer_glyph() {
+
+  return (random() % 0x4E) + 0XA6;
+}
+
 void reset_streamer(struct sStreamer *s, int nXmax, int nYmax) {
 
   s->nXpos = (int)random() % nXmax;
@@ -34,53 +55,185 @@ void reset_streamer(struct sStreamer *s, int nXmax, int nYmax) {
   s->fSpeed = (float)((int)random() % 15) + 5.0f;
 
   for (size_t i = 0; i < s->nChars; i++)
-    s->sChars[i] = (random() % 0x4E) + 0XA6;
+    s->sChars[i] = streamer_glyph();
+}
+
+// fast streamers are brighter
+int streamer_tone(struct sStreamer *s) {
+
+  int nTone = (int)((s->fSpeed - 5.0f) * PALETTETONES / 15.0f);
+
+  return nTone < PALETTETONES ? nTone : PALETTETONES - 1;
+}
+
+// streamers and their glyphs share one arena
+struct sStreamer *alloc_streamers(struct arena *pArena, size_t nStreamers,
+                                  size_t nYmax) {
+
+  arena_reset(pArena);
+
+  struct sStreamer *streamers = (struct sStreamer *)arena_alloc(
+      pArena, nStreamers * sizeof(struct sStreamer));
+
+  for (size_t i = 0; streamers && i < nStreamers; i++)
+    if ((streamers[i].sChars = (wchar_t *)arena_alloc(
+             pArena, ((nYmax - 10) + 6) * sizeof(wchar_t))) == NULL)
+      return NULL;
+
+  return streamers;
 }
 
-int main() {
-
-  enum colors {
-    BLACK = 1,
-    LIGHT_GREEN,
-    MEDIUM_GREEN,
-    DARK_GREEN,
-    WHITE,
-    GRAY,
-    DARK_GRAY,
-
-    BLACK1,
-    LIGHT_GREEN1,
-    MEDIUM_GREEN1,
-    DARK_GREEN1,
-    WHITE1,
-    GRAY1,
-    DARK_GRAY1,
-
-    BLACK2,
-    LIGHT_GREEN2,
-    MEDIUM_GREEN2,
-    DARK_GREEN2,
-    WHITE2,
-    GRAY2,
-    DARK_GRAY2,
-
-    NCOLORS
-  };
-
-  // https://jonasjacek.github.io/colors/
-  static const short ColorNum[] = {-1,  232, 119, 112, 64,  255, 252, 242,
-                                   235, 121, 114, 66,  253, 249, 240, 234,
-                                   120, 113, 65,  251, 247, 238};
-
-  size_t nXmax = 0, nYmax = 0, nKey = ERR, nColor = 0, nIndex = 0,
-         nCharStart = 0, nCharStop = 0, nChar = 0, iChar = 0, nSection = 0,
-         nOffset = 0;
+// MUTATIONS entries per streamer, each due again a random number of frames
+// after it changed a glyph
+int schedule_mutations(struct wheel *pWheel, struct arena *pArena,
+                       size_t nStreamers) {
+
+  if (wheel_init(pWheel, pArena, nStreamers * MUTATIONS) == -1)
+    return -1;
+
+  for (size_t i = 0; i < pWheel->nentries; i++)
+    wheel_add(pWheel, &pWheel->entries[i], 1 + random() % (WHEELSLOTS - 1));
+
+  return 0;
+}
+
+// only the glyphs due are visited, the term diff sends just their cells
+size_t mutate_streamers(struct wheel *pWheel, struct sStreamer *streamers) {
+
+  size_t nMutations = 0;
+
+  struct wheel_entry *pEntry = wheel_tick(pWheel), *pNext;
+
+  for (; pEntry; pEntry = pNext) {
+
+    pNext = pEntry->next;
+
+    struct sStreamer *s = &streamers[wheel_index(pWheel, pEntry) / MUTATIONS];
+
+    s->sChars[random() % s->nChars] = streamer_glyph();
+
+    ++nMutations;
+
+    wheel_add(pWheel, pEntry, 1 + random() % (WHEELSLOTS - 1));
+  }
+
+  return nMutations;
+}
+
+int main(int argc, char *argv[]) {
+
+  size_t nXmax = 0, nYmax = 0, nKey = ERR, nIndex = 0, nCharStart = 0,
+         nCharStop = 0, nChar = 0, iChar = 0, nOffset = 0;
+
+  int nTone = 0, nShade = 0;
 
   useconds_t nMicroSeconds = 0;
 
-  struct timespec sStartTimespec, sStopTimespec;
+  uint64_t nStart, nStop, nComposed, nOutput, nInput, nPrevious = 0;
+
+  bool bFinished = false, bPaused = false, bFrameTime = false, bRaw = false,
+       bSync = false, bWall = false;
+
+  struct term sTerm;
+
+  struct wall sWall;
+
+  char *pOutputs[WALLMAX];
+
+  struct record sRecord;
+
+  char *pRecordFile = NULL, *pMetricsTarget = NULL, *pTraceFile = NULL,
+       *pPalette = PALETTEDEFAULT;
+
+  struct palette sPalette;
+
+  struct metrics sMetrics;
 
-  bool bFinished = false, bPaused = false, bFrameTime = false;
+  struct wheel sWheels[2];
+
+  int nOpt, nThreads = 1, nOutputs = 0, nTiles = 0;
+
+  while ((nOpt = getopt(argc, argv, "c:e:j:o:R:rSt:T:")) != -1) {
+    switch (nOpt) {
+    case 'c':
+      pPalette = optarg;
+      break;
+    case 'e':
+      pMetricsTarget = optarg;
+      break;
+    case 'j':
+      nThreads = atoi(optarg);
+      if (nThreads < 1 || nThreads > TERMMAXBANDS) {
+        fprintf(stderr, "threads must be within 1 and %d\n", TERMMAXBANDS);
+        return 1;
+      }
+      bRaw = true;
+      break;
+    case 'o':
+      if (nOutputs == WALLMAX) {
+        fprintf(stderr, "at most %d outputs\n", WALLMAX);
+        return 1;
+      }
+      pOutputs[nOutputs++] = optarg;
+      bWall = bRaw = true;
+      break;
+    case 'R':
+      pRecordFile = optarg;
+      bRaw = true;
+      break;
+    case 'S':
+      bSync = true;
+      bRaw = true;
+      break;
+    case 'r':
+      bRaw = true;
+      break;
+    case 't':
+      nTiles = atoi(optarg);
+      break;
+    case 'T':
+      pTraceFile = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-c palette] [-e target] [-j threads] "
+              "[-o tty [-t tiles]] [-r] [-R file] [-S] [-T file]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (palette_init(&sPalette, pPalette, 0, 0) == -1) {
+    fprintf(stderr, "palette must be 2 to %d comma separated rrggbb\n",
+            PALETTEMAX);
+    return 1;
+  }
+
+  if (pRecordFile && record_open(&sRecord, pRecordFile) == -1) {
+    fprintf(stderr, "unable to record to %s\n", pRecordFile);
+    return 1;
+  }
+
+  if (metrics_init(&sMetrics, "matrix", pMetricsTarget) == -1) {
+    fprintf(stderr, "unable to export metrics to %s\n", pMetricsTarget);
+    return 1;
+  }
+
+  if (pTraceFile && trace_open(pTraceFile) == -1) {
+    fprintf(stderr, "unable to trace to %s\n", pTraceFile);
+    return 1;
+  }
+
+  int nFrameMetric = metrics_histogram(&sMetrics, "frame_ns", true),
+      nUpdateMetric = metrics_histogram(&sMetrics, "update_ns", true),
+      nOutputMetric = metrics_histogram(&sMetrics, "output_ns", true),
+      nInputMetric = metrics_histogram(&sMetrics, "input_ns", true),
+      nCellsMetric = metrics_histogram(&sMetrics, "cells", false),
+      nBytesMetric = metrics_histogram(&sMetrics, "bytes", false),
+      nWritesMetric = metrics_counter(&sMetrics, "writes"),
+      nLateMetric = metrics_counter(&sMetrics, "late"),
+      nPairsMetric = metrics_counter(&sMetrics, "pair_inits"),
+      nMutationsMetric = metrics_counter(&sMetrics, "mutations");
 
   setlocale(LC_ALL, "");
 
@@ -104,23 +257,67 @@ int main() {
 
   getmaxyx(stdscr, nYmax, nXmax);
 
-  for (short i = BLACK; i < NCOLORS; i++)
-    init_pair(i, ColorNum[i], -1);
+  // ncurses keeps the input, frames bypass it
+  if (bRaw) {
+    refresh();
+    // one canvas for all outputs, the local terminal shows its top left
+    if (bWall) {
+      if (wall_open(&sWall, pOutputs, nOutputs, nTiles, nYmax, nXmax,
+                    bSync) == -1) {
+        endwin();
+        fprintf(stderr, "unable to open the outputs\n");
+        return 1;
+      }
+      nYmax = sWall.rows;
+      nXmax = sWall.cols;
+    }
+    bRaw = term_init(&sTerm, STDOUT_FILENO, nYmax, nXmax, bSync) == 0;
+    if (bWall && !bRaw) {
+      wall_close(&sWall);
+      endwin();
+      fprintf(stderr, "unable to allocate the canvas\n");
+      return 1;
+    }
+    // the rows are split in bands, one per thread
+    if (bRaw && nThreads > 1)
+      term_threads(&sTerm, nThreads - 1);
+    if (bRaw && pRecordFile)
+      sTerm.record = &sRecord;
+  }
+
+  // raw frames take xterm colours, only ncurses needs the pairs
+  if (!bRaw)
+    palette_init(&sPalette, pPalette, COLORS, COLOR_PAIRS);
 
   size_t nStreamers = nXmax / 3;
 
-  struct sStreamer *streamers =
-      (struct sStreamer *)malloc(nStreamers * sizeof(struct sStreamer));
+  // a resize builds the streamers and their wheel anew in the other arena
+  struct arena sArenas[2];
 
-  for (size_t i = 0; i < nStreamers; i++) {
-    streamers[i].sChars =
-        (wchar_t *)malloc(((nYmax - 10) + 6) * sizeof(wchar_t));
-    reset_streamer(&streamers[i], nXmax, nYmax);
+  int nArena = 0;
+
+  struct sStreamer *streamers = NULL;
+
+  if (arena_init(&sArenas[0], ARENASIZE) == 0 &&
+      arena_init(&sArenas[1], ARENASIZE) == 0)
+    streamers = alloc_streamers(&sArenas[nArena], nStreamers, nYmax);
+
+  if (streamers == NULL ||
+      schedule_mutations(&sWheels[nArena], &sArenas[nArena], nStreamers) ==
+          -1) {
+    if (bWall)
+      wall_close(&sWall);
+    endwin();
+    fprintf(stderr, "unable to allocate streamers\n");
+    return 1;
   }
 
+  for (size_t i = 0; i < nStreamers; i++)
+    reset_streamer(&streamers[i], nXmax, nYmax);
+
   while (!bFinished) {
 
-    clock_gettime(CLOCK_MONOTONIC_RAW, &sStartTimespec);
+    nStart = metrics_now();
 
     if (nKey == 'q')
       bFinished = true;
@@ -131,54 +328,86 @@ int main() {
     if (nKey == 'f')
       bFrameTime = !bFrameTime;
 
-    if (nKey == KEY_RESIZE) {
+    if (nKey == 'h')
+      sMetrics.hud = !sMetrics.hud;
+
+    if (nKey == KEY_RESIZE && bWall) {
+
+      int nRows, nCols;
+
+      getmaxyx(stdscr, nRows, nCols);
+
+      wall_resize(&sWall, nRows, nCols);
+
+      refresh();
+    } else if (nKey == KEY_RESIZE) {
 
       size_t nNewXmax, nNewYmax;
 
       getmaxyx(stdscr, nNewYmax, nNewXmax);
 
-      nStreamers = nNewXmax / 3;
-
-      if (nNewXmax < nXmax) {
-        for (size_t i = nStreamers; i < nXmax / 3; i++) {
-          free(streamers[i].sChars);
-        }
-      }
+      size_t nNewStreamers = nNewXmax / 3;
 
-      streamers = (struct sStreamer *)realloc(
-          streamers, nStreamers * sizeof(struct sStreamer));
+      struct sStreamer *pNew =
+          alloc_streamers(&sArenas[!nArena], nNewStreamers, nNewYmax);
 
-      if (nNewXmax > nXmax) {
-        for (size_t i = nXmax / 3; i < nStreamers; i++) {
-          streamers[i].sChars =
-              (wchar_t *)malloc(((nNewYmax - 10) + 6) * sizeof(wchar_t));
-          reset_streamer(&streamers[i], nNewXmax, nNewYmax);
-        }
+      if (pNew == NULL || schedule_mutations(&sWheels[!nArena],
+                                             &sArenas[!nArena],
+                                             nNewStreamers) == -1) {
+        bFinished = true;
+        continue;
       }
 
-      if (nNewYmax != nYmax) {
-        for (size_t i = 0; i < nNewXmax / 3; i++) {
-          streamers[i].sChars = (wchar_t *)realloc(
-              streamers[i].sChars, ((nNewYmax - 10) + 6) * sizeof(wchar_t));
-          if ((size_t)streamers[i].fYpos >= nNewYmax ||
-              streamers[i].nXpos >= nXmax) {
-            reset_streamer(&streamers[i], nNewXmax, nNewYmax);
-          } else if (streamers[i].nChars > ((nNewYmax - 10) + 6)) {
-            streamers[i].nChars = (nNewYmax - 10) + 6;
-          }
+      for (size_t i = 0; i < nNewStreamers; i++) {
+        if (i >= nStreamers) {
+          reset_streamer(&pNew[i], nNewXmax, nNewYmax);
+          continue;
         }
+        wchar_t *sChars = pNew[i].sChars;
+        pNew[i] = streamers[i];
+        pNew[i].sChars = sChars;
+        if (pNew[i].nChars > ((nNewYmax - 10) + 6))
+          pNew[i].nChars = (nNewYmax - 10) + 6;
+        memcpy(sChars, streamers[i].sChars, pNew[i].nChars * sizeof(wchar_t));
+        if ((size_t)pNew[i].fYpos >= nNewYmax || pNew[i].nXpos >= nNewXmax)
+          reset_streamer(&pNew[i], nNewXmax, nNewYmax);
       }
 
+      streamers = pNew;
+      nStreamers = nNewStreamers;
+      nArena = !nArena;
+
       nXmax = nNewXmax;
       nYmax = nNewYmax;
+
+      if (bRaw) {
+        refresh();
+        term_resize(&sTerm, nYmax, nXmax);
+      }
     }
 
     if (!bPaused) {
 
-      clear();
+      if (bRaw)
+        term_erase(&sTerm);
+      else
+        clear();
+
+      // pairs are (re)initialized here, not per glyph
+      unsigned int nTones = 0;
+
+      for (size_t i = 0; i < nStreamers; i++)
+        nTones |= 1u << streamer_tone(&streamers[i]);
+
+      metrics_add(&sMetrics, nPairsMetric, palette_frame(&sPalette, nTones));
+
+      metrics_add(&sMetrics, nMutationsMetric,
+                  mutate_streamers(&sWheels[nArena], streamers));
 
       for (size_t i = 0; i < nStreamers; i++) {
 
+        nTone = streamer_tone(&streamers[i]);
+
         nCharStart = (size_t)streamers[i].fYpos >= streamers[i].nChars
                          ? 0
                          : streamers[i].nChars - (int)streamers[i].fYpos;
@@ -202,96 +431,117 @@ int main() {
 
           iChar = nOffset - j - 1;
 
-          if (streamers[i].fSpeed < 10.0f) {
-            if (iChar == 0)
-              nColor = WHITE;
-            else {
-              nSection = iChar / ((streamers[i].nChars - 1) / 5);
-              if (nSection == 0)
-                nColor = LIGHT_GREEN;
-              else if (nSection == 1)
-                nColor = MEDIUM_GREEN;
-              else if (nSection == 2)
-                nColor = DARK_GREEN;
-              else if (nSection == 3)
-                nColor = DARK_GRAY;
-              else
-                nColor = BLACK;
-            }
-          } else if (streamers[i].fSpeed > 15.0f) {
-            if (iChar == 0)
-              nColor = WHITE1;
-            else {
-              nSection = iChar / ((streamers[i].nChars - 1) / 5);
-              if (nSection == 0)
-                nColor = LIGHT_GREEN1;
-              else if (nSection == 1)
-                nColor = MEDIUM_GREEN1;
-              else if (nSection == 2)
-                nColor = DARK_GREEN1;
-              else if (nSection == 3)
-                nColor = DARK_GRAY1;
-              else
-                nColor = BLACK1;
-            }
-          } else {
-            if (iChar == 0)
-              nColor = WHITE2;
-            else {
-              nSection = iChar / ((streamers[i].nChars - 1) / 5);
-              if (nSection == 0)
-                nColor = LIGHT_GREEN2;
-              else if (nSection == 1)
-                nColor = MEDIUM_GREEN2;
-              else if (nSection == 2)
-                nColor = DARK_GREEN2;
-              else if (nSection == 3)
-                nColor = DARK_GRAY2;
-              else
-                nColor = BLACK2;
-            }
-          }
-
-          attron(COLOR_PAIR(nColor));
+          nShade = iChar * (PALETTESHADES - 1) / (streamers[i].nChars - 1);
 
           nIndex =
               ((int)streamers[i].fYpos + nCharStart + j) % streamers[i].nChars;
 
+          if (bRaw) {
+            term_pen(&sTerm, sPalette.xterm[nTone][nShade], -1, 0);
+            term_put(&sTerm, (int)streamers[i].fYpos + j - nOffset,
+                     streamers[i].nXpos, streamers[i].sChars[nIndex]);
+            continue;
+          }
+
+          palette_set(&sPalette, nTone, nShade);
+
           mvprintw((int)streamers[i].fYpos + j - nOffset, streamers[i].nXpos,
                    "%lc", streamers[i].sChars[nIndex]);
-
-          attroff(COLOR_PAIR(nColor));
         }
 
         streamers[i].fYpos += streamers[i].fSpeed * 0.03f;
       }
+
+      if (!bRaw)
+        attr_set(A_NORMAL, 0, NULL);
     }
 
-    clock_gettime(CLOCK_MONOTONIC_RAW, &sStopTimespec);
+    nStop = metrics_now();
 
-    nMicroSeconds = (sStopTimespec.tv_sec - sStartTimespec.tv_sec) * 1000000 +
-                    (sStopTimespec.tv_nsec - sStartTimespec.tv_nsec) / 1000;
+    nMicroSeconds = (nStop - nStart) / 1000;
 
-    if (bFrameTime) {
-      mvprintw(nYmax - 1, 0, "frame time: %lld us", nMicroSeconds);
+    if (bFrameTime && bRaw) {
+      term_pen(&sTerm, -1, -1, 0);
+      term_printw(&sTerm, nYmax - 1, 0, "frame time: %llu us",
+                  (unsigned long long)nMicroSeconds);
+    } else if (bFrameTime) {
+      mvprintw(nYmax - 1, 0, "frame time: %llu us",
+               (unsigned long long)nMicroSeconds);
     }
 
-    nKey = getch(); // calls refresh
+    if (sMetrics.hud) {
+      char sLine[METRICSLINE];
+      if (bRaw)
+        term_pen(&sTerm, -1, -1, 0);
+      for (int i = 0; metrics_hud(&sMetrics, i, sLine, METRICSLINE); i++)
+        if (bRaw)
+          term_printw(&sTerm, i, 0, "%s", sLine);
+        else
+          mvprintw(i, 0, "%s", sLine);
+    }
+
+    nComposed = metrics_now();
+
+    if (bRaw) {
+      metrics_observe(&sMetrics, nBytesMetric,
+                      bWall ? wall_frame(&sWall, &sTerm) : term_frame(&sTerm));
+      metrics_observe(&sMetrics, nCellsMetric, sTerm.cells);
+      metrics_add(&sMetrics, nWritesMetric, sTerm.writes);
+    } else
+      refresh();
 
-    if (nMicroSeconds < 0 || nMicroSeconds >= 40000) {
+    nOutput = metrics_now();
+
+    nKey = getch();
+
+    nInput = metrics_now();
+
+    allocguard_frame();
+
+    if (nPrevious)
+      metrics_observe(&sMetrics, nFrameMetric, nStart - nPrevious);
+    metrics_observe(&sMetrics, nUpdateMetric, nStop - nStart);
+    metrics_observe(&sMetrics, nOutputMetric, nOutput - nStop);
+    metrics_observe(&sMetrics, nInputMetric, nInput - nOutput);
+
+    trace_span("simulate", nStart, nStop);
+    trace_span("compose", nStop, nComposed);
+    trace_span("flush", nComposed, nOutput);
+    trace_span("input", nOutput, nInput);
+
+    metrics_tick(&sMetrics, nStart);
+
+    nPrevious = nStart;
+
+    // the frame missed its slot of 40 ms
+    if (nMicroSeconds >= 40000) {
+      metrics_add(&sMetrics, nLateMetric, 1);
       continue;
     }
 
     usleep(40000 - nMicroSeconds);
   }
 
+  if (bWall)
+    wall_close(&sWall);
+
   fflush(stdout);
 
   endwin();
 
-  for (size_t i = 0; i < nStreamers; i++)
-    free(streamers[i].sChars);
-  free(streamers);
+  if (bRaw)
+    term_free(&sTerm);
+
+  if (pRecordFile)
+    record_close(&sRecord);
+
+  metrics_free(&sMetrics);
+
+  if (pTraceFile)
+    trace_close();
+
+  arena_free(&sArenas[0]);
+  arena_free(&sArenas[1]);
 
   return 0;
 }
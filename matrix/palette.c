@@ -0,0 +1,275 @@
+/**
+ *  @file   palette.c
+ *  @brief  Streamer Gradients on Cached Colour Pairs
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "palette.h"
+
+#include <ncurses.h>
+#include <stdlib.h>
+#include <string.h>
+
+// pairs and colours beyond a short came with ncurses 6.1
+#if defined(NCURSES_VERSION_PATCH) && NCURSES_VERSION_PATCH >= 20170401
+#define PALETTEEXTENDED
+#endif
+
+// 16 system colours, a 6x6x6 cube and 24 greys
+static unsigned int palette_xterm(int index) {
+
+  static const unsigned int system[] = {
+      0x000000, 0x800000, 0x008000, 0x808000, 0x000080, 0x800080,
+      0x008080, 0xc0c0c0, 0x808080, 0xff0000, 0x00ff00, 0xffff00,
+      0x0000ff, 0xff00ff, 0x00ffff, 0xffffff};
+  static const unsigned int level[] = {0, 95, 135, 175, 215, 255};
+
+  if (index < 16)
+    return (system[index]);
+
+  if (index < 232) {
+    index -= 16;
+    return (level[index / 36] << 16 | level[index / 6 % 6] << 8 |
+            level[index % 6]);
+  }
+
+  unsigned int grey = 8 + (index - 232) * 10;
+
+  return (grey << 16 | grey << 8 | grey);
+}
+
+static int palette_distance(unsigned int a, unsigned int b) {
+
+  int distance = 0;
+
+  for (int shift = 16; shift >= 0; shift -= 8) {
+    int d = (int)(a >> shift & 0xff) - (int)(b >> shift & 0xff);
+    distance += d * d;
+  }
+
+  return (distance);
+}
+
+// themes change the system colours, so they are only used without the cube
+static int palette_nearest(unsigned int rgb, int colours) {
+
+  int first = colours >= 256 ? 16 : 0, last = colours >= 256 ? 256 : colours,
+      nearest = first, best = -1;
+
+  for (int i = first; i < last; i++) {
+    int distance = palette_distance(rgb, palette_xterm(i));
+    if (best == -1 || distance < best) {
+      best = distance;
+      nearest = i;
+    }
+  }
+
+  return (nearest);
+}
+
+static int palette_parse(struct palette *palette, const char *stops) {
+
+  const char *p = stops;
+
+  while (*p) {
+    if (palette->nstops == PALETTEMAX)
+      return (-1);
+    if (*p == '#')
+      ++p;
+    char *end;
+    unsigned long rgb = strtoul(p, &end, 16);
+    if (end - p != 6)
+      return (-1);
+    palette->stops[palette->nstops++] = rgb;
+    p = end;
+    if (*p == ',')
+      ++p;
+    else if (*p)
+      return (-1);
+  }
+
+  return (palette->nstops < 2 ? -1 : 0);
+}
+
+// linear between the two stops around the shade, dimmed for slow tones
+static unsigned int palette_rgb(const struct palette *palette, int tone,
+                                int shade) {
+
+  float pos = (float)shade * (palette->nstops - 1) / (PALETTESHADES - 1),
+        brightness = 0.55f + 0.45f * tone / (PALETTETONES - 1);
+
+  int i = pos < palette->nstops - 1 ? (int)pos : palette->nstops - 2;
+
+  float f = pos - i;
+
+  unsigned int a = palette->stops[i], b = palette->stops[i + 1], rgb = 0;
+
+  for (int shift = 16; shift >= 0; shift -= 8) {
+    float c = ((a >> shift & 0xff) * (1.0f - f) + (b >> shift & 0xff) * f) *
+              brightness;
+    rgb |= (unsigned int)(c + 0.5f) << shift;
+  }
+
+  return (rgb);
+}
+
+static void palette_bind(struct palette *palette, int id, int pair) {
+
+  if (palette->owner[pair] >= 0)
+    palette->pair_of[palette->owner[pair]] = 0;
+
+#ifdef PALETTEEXTENDED
+  init_extended_pair(pair, palette->colour[id], -1);
+#else
+  init_pair(pair, palette->colour[id], -1);
+#endif
+
+  palette->owner[pair] = id;
+  palette->pair_of[id] = pair;
+}
+
+// a free pair or the least recently used, 0 when all are used this frame
+static int palette_victim(struct palette *palette) {
+
+  int victim = 0;
+  unsigned long oldest = palette->frame;
+
+  for (int pair = 1; pair <= palette->npairs; pair++) {
+    int id = palette->owner[pair];
+    if (id < 0)
+      return (pair);
+    if (palette->used[id] < oldest) {
+      oldest = palette->used[id];
+      victim = pair;
+    }
+  }
+
+  return (victim);
+}
+
+// bit reversed, the head and tail first, then ever finer in between
+static int palette_order(int i) {
+
+  int shade = 0;
+
+  for (int bit = 1; bit < PALETTESHADES; bit <<= 1) {
+    shade = shade << 1 | (i & 1);
+    i >>= 1;
+  }
+
+  return (shade);
+}
+
+static int palette_fill(struct palette *palette, unsigned int mask,
+                        int budget) {
+
+  int inits = 0;
+
+  ++palette->frame;
+
+  for (int tone = 0; tone < PALETTETONES; tone++)
+    for (int shade = 0; mask & 1u << tone && shade < PALETTESHADES; shade++) {
+      int id = palette->id[tone][shade];
+      if (palette->pair_of[id])
+        palette->used[id] = palette->frame;
+    }
+
+  for (int i = 0; i < PALETTESHADES && inits < budget; i++)
+    for (int tone = 0; tone < PALETTETONES && inits < budget; tone++) {
+      int id = palette->id[tone][palette_order(i)], pair;
+      if (!(mask & 1u << tone) || palette->pair_of[id] ||
+          (pair = palette_victim(palette)) == 0)
+        continue;
+      palette_bind(palette, id, pair);
+      palette->used[id] = palette->frame;
+      ++inits;
+    }
+
+  for (int tone = 0; tone < PALETTETONES; tone++)
+    for (int shade = 0; shade < PALETTESHADES; shade++) {
+      int id = palette->id[tone][shade], pair = palette->pair_of[id], best = -1;
+      for (int other = 1; pair == 0 && other <= palette->npairs; other++) {
+        if (palette->owner[other] < 0)
+          continue;
+        int distance = palette_distance(palette->rgb[id],
+                                        palette->rgb[palette->owner[other]]);
+        if (best == -1 || distance < best) {
+          best = distance;
+          pair = other;
+        }
+      }
+      palette->pair[tone][shade] = pair;
+    }
+
+  return (inits);
+}
+
+int palette_init(struct palette *palette, const char *stops, int colours,
+                 int pairs) {
+
+  memset(palette, 0, sizeof(struct palette));
+
+  if (palette_parse(palette, stops) == -1)
+    return (-1);
+
+#ifdef PALETTEEXTENDED
+  bool direct = colours >= 1 << 24;
+#else
+  bool direct = false;
+  if (colours > 256)
+    colours = 256;
+#endif
+
+  for (int tone = 0; tone < PALETTETONES; tone++)
+    for (int shade = 0; shade < PALETTESHADES; shade++) {
+      unsigned int rgb = palette_rgb(palette, tone, shade);
+      palette->xterm[tone][shade] = palette_nearest(rgb, 256);
+      int colour = direct          ? (int)rgb
+                   : colours > 0 ? palette_nearest(rgb, colours)
+                                 : palette->xterm[tone][shade],
+          id = 0;
+      while (id < palette->ncolours && palette->colour[id] != colour)
+        ++id;
+      if (id == palette->ncolours) {
+        palette->colour[id] = colour;
+        palette->rgb[id] = direct ? rgb : palette_xterm(colour);
+        ++palette->ncolours;
+      }
+      palette->id[tone][shade] = id;
+    }
+
+  if (colours > 0)
+    palette->npairs = pairs - 1 < palette->ncolours ? pairs - 1
+                                                    : palette->ncolours;
+
+  for (int pair = 0; pair <= palette->npairs; pair++)
+    palette->owner[pair] = -1;
+
+  // the first frame need not wait for its pairs
+  if (palette->npairs > 0)
+    palette_fill(palette, ~0u, palette->npairs);
+
+  return (0);
+}
+
+int palette_frame(struct palette *palette, unsigned int mask) {
+
+  if (palette->npairs == 0)
+    return (0);
+
+  return (palette_fill(palette, mask, PALETTEBUDGET));
+}
+
+void palette_set(const struct palette *palette, int tone, int shade) {
+
+  int pair = palette->pair[tone][shade];
+
+#ifdef PALETTEEXTENDED
+  attr_set(A_NORMAL, 0, &pair);
+#else
+  attr_set(A_NORMAL, (short)pair, NULL);
+#endif
+}
@@ -0,0 +1,56 @@
+/**
+ *  @file   palette.h
+ *  @brief  Streamer Gradients on Cached Colour Pairs
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef PALETTE_H_
+#define PALETTE_H_
+
+#include <stdbool.h>
+
+#define PALETTEMAX 8
+#define PALETTESHADES 32 // a power of two
+#define PALETTETONES 4
+#define PALETTECOLOURS (PALETTESHADES * PALETTETONES)
+#define PALETTEBUDGET 8
+
+// head first, white fading through the greens into the background
+#define PALETTEDEFAULT "eeeeee,87ff5f,87d700,5f8700,6c6c6c,080808"
+
+// shades run from the head of a streamer to its tail, tones from the dim
+// slow streamers to the bright fast ones; every shade of every tone is mapped
+// once to a colour of the terminal, the xterm palette or, when the terminal
+// has direct colour, rgb, and the distinct ones share pairs that are
+// (re)initialized at most PALETTEBUDGET times per frame, least recently used
+// first once the terminal runs out; shades are given pairs coarse to fine,
+// so a few pairs still span the gradient, and those without borrow the
+// nearest colour that has one
+struct palette {
+  int nstops;
+  unsigned int stops[PALETTEMAX];
+  short xterm[PALETTETONES][PALETTESHADES]; // for the raw output
+  unsigned char id[PALETTETONES][PALETTESHADES];
+  int ncolours, colour[PALETTECOLOURS];
+  unsigned int rgb[PALETTECOLOURS]; // as shown
+  int npairs, pair_of[PALETTECOLOURS], owner[PALETTECOLOURS + 1];
+  unsigned long used[PALETTECOLOURS], frame;
+  int pair[PALETTETONES][PALETTESHADES]; // what to draw with this frame
+};
+
+// stops are comma separated rrggbb; colours and pairs are the terminal's,
+// 0 for the raw output only; returns -1 for a bad description
+int palette_init(struct palette *palette, const char *stops, int colours,
+                 int pairs);
+
+// make the shades of the tones in mask resident, returns the number of pairs
+// initialized
+int palette_frame(struct palette *palette, unsigned int mask);
+
+// the attributes for a shade of a tone, for the ncurses output
+void palette_set(const struct palette *palette, int tone, int shade);
+
+#endif // PALETTE_H_
@@ -0,0 +1,51 @@
+/**
+ *  @file   wheel.c
+ *  @brief  Timing Wheel of Preallocated Entries
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "wheel.h"
+
+#include <string.h>
+
+int wheel_init(struct wheel *wheel, struct arena *arena, size_t nentries) {
+
+  memset(wheel, 0, sizeof(struct wheel));
+
+  wheel->entries = (struct wheel_entry *)arena_alloc(
+      arena, (nentries ? nentries : 1) * sizeof(struct wheel_entry));
+  if (wheel->entries == NULL)
+    return (-1);
+
+  wheel->nentries = nentries;
+
+  return (0);
+}
+
+void wheel_add(struct wheel *wheel, struct wheel_entry *entry,
+               unsigned int delay) {
+
+  if (delay < 1)
+    delay = 1;
+  else if (delay > WHEELSLOTS - 1)
+    delay = WHEELSLOTS - 1;
+
+  struct wheel_entry **slot =
+      &wheel->slots[(wheel->tick + delay) & (WHEELSLOTS - 1)];
+
+  entry->next = *slot;
+  *slot = entry;
+}
+
+struct wheel_entry *wheel_tick(struct wheel *wheel) {
+
+  struct wheel_entry **slot = &wheel->slots[++wheel->tick & (WHEELSLOTS - 1)],
+                     *due = *slot;
+
+  *slot = NULL;
+
+  return (due);
+}
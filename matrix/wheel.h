@@ -0,0 +1,48 @@
+/**
+ *  @file   wheel.h
+ *  @brief  Timing Wheel of Preallocated Entries
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef WHEEL_H_
+#define WHEEL_H_
+
+#include <stddef.h>
+
+#include "arena.h"
+
+#define WHEELSLOTS 64 // a power of two
+
+struct wheel_entry {
+  struct wheel_entry *next;
+};
+
+// a slot per tick, each holding the entries due then, so a tick only visits
+// what is due; delays run from 1 to WHEELSLOTS - 1 ticks and entries are
+// taken from the arena once, scheduling never allocates
+struct wheel {
+  struct wheel_entry *slots[WHEELSLOTS], *entries;
+  size_t nentries;
+  unsigned long tick;
+};
+
+// returns -1 when the arena runs out, no entry is scheduled yet
+int wheel_init(struct wheel *wheel, struct arena *arena, size_t nentries);
+
+// clamped to the range of the wheel
+void wheel_add(struct wheel *wheel, struct wheel_entry *entry,
+               unsigned int delay);
+
+// advance a tick, returns the entries due, taken off the wheel
+struct wheel_entry *wheel_tick(struct wheel *wheel);
+
+static inline size_t wheel_index(const struct wheel *wheel,
+                                 const struct wheel_entry *entry) {
+
+  return (entry - wheel->entries);
+}
+
+#endif // WHEEL_H_
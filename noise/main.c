@@ -9,19 +9,149 @@
 
 #include <locale.h>
 #include <ncurses.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <time.h>
+#include <unistd.h>
+
+#include "allocguard.h"
+#include "metrics.h"
+#include "record.h"
+#include "tape.h"
+#include "term.h"
+#include "trace.h"
+#include "wall.h"
 
 int main(int argc, char *argv[], char **envp) {
 
   int nX = 0, nY = 0, nXmax = 0, nYmax = 0, nKey;
 
-  float fMicroSeconds = 0.0f;
+  uint64_t nStart = 0, nStop, nUpdated, nComposed, nOutput, nInput, nFrameNs;
+
+  bool bFinished = false, bPaused = false, bRaw = false, bSync = false,
+       bHalf = false, bWall = false, bTape = false;
+
+  struct term sTerm;
+
+  struct wall sWall;
+
+  struct tape sTape;
+
+  char *pOutputs[WALLMAX];
+
+  struct record sRecord;
+
+  char *pRecordFile = NULL, *pMetricsTarget = NULL, *pTraceFile = NULL;
+
+  struct metrics sMetrics;
+
+  int nOpt, nThreads = 1, nOutputs = 0, nTiles = 0, nTapeMiB = 0;
+
+  while ((nOpt = getopt(argc, argv, "de:j:o:P:R:rSt:T:")) != -1) {
+    switch (nOpt) {
+    case 'd':
+      bHalf = true;
+      bRaw = true;
+      break;
+    case 'e':
+      pMetricsTarget = optarg;
+      break;
+    case 'j':
+      nThreads = atoi(optarg);
+      if (nThreads < 1 || nThreads > TERMMAXBANDS) {
+        fprintf(stderr, "threads must be within 1 and %d\n", TERMMAXBANDS);
+        return 1;
+      }
+      bRaw = true;
+      break;
+    case 'o':
+      if (nOutputs == WALLMAX) {
+        fprintf(stderr, "at most %d outputs\n", WALLMAX);
+        return 1;
+      }
+      pOutputs[nOutputs++] = optarg;
+      bWall = bRaw = true;
+      break;
+    case 'P':
+      nTapeMiB = atoi(optarg);
+      if (nTapeMiB < 1 || nTapeMiB > 4096) {
+        fprintf(stderr, "tape must be within 1 and 4096 MiB\n");
+        return 1;
+      }
+      bTape = true;
+      break;
+    case 'R':
+      pRecordFile = optarg;
+      bRaw = true;
+      break;
+    case 'S':
+      bSync = true;
+      bRaw = true;
+      break;
+    case 'r':
+      bRaw = true;
+      break;
+    case 't':
+      nTiles = atoi(optarg);
+      break;
+    case 'T':
+      pTraceFile = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-d] [-e target] [-j threads] [-o tty [-t tiles]] "
+              "[-P MiB] [-r] [-R file] [-S] [-T file]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (bTape && (bWall || pRecordFile)) {
+    fprintf(stderr, "-P does not combine with -o or -R\n");
+    return 1;
+  }
+
+  wchar_t pixels[] = {L' ', L'\u2591', L'\u2592', L'\u2593', L'\u2588'};
+
+  // an en space, as every glyph on the tape takes three bytes
+  wchar_t tiles[] = {L'\u2002', L'\u2591', L'\u2592', L'\u2593', L'\u2588'},
+          halves[] = {L'\u2002', L'\u2580', L'\u2584', L'\u2588'};
+
+  // half block pixels are on or off, so every cell shares one pen
+  short dots[] = {-1, 15};
+
+  // encoded up front, frames are then copied from it row by row
+  if (bTape && (bHalf ? tape_init(&sTape, (size_t)nTapeMiB << 20, halves, 4,
+                                  dots[1], bSync)
+                      : tape_init(&sTape, (size_t)nTapeMiB << 20, tiles, 5,
+                                  -1, bSync)) == -1) {
+    fprintf(stderr, "unable to map a tape of %d MiB\n", nTapeMiB);
+    return 1;
+  }
 
-  struct timespec sStartTimespec, sStopTimespec;
+  if (pRecordFile && record_open(&sRecord, pRecordFile) == -1) {
+    fprintf(stderr, "unable to record to %s\n", pRecordFile);
+    return 1;
+  }
+
+  if (metrics_init(&sMetrics, "noise", pMetricsTarget) == -1) {
+    fprintf(stderr, "unable to export metrics to %s\n", pMetricsTarget);
+    return 1;
+  }
 
-  bool bFinished = false, bPaused = false;
+  if (pTraceFile && trace_open(pTraceFile) == -1) {
+    fprintf(stderr, "unable to trace to %s\n", pTraceFile);
+    return 1;
+  }
+
+  int nFrameMetric = metrics_histogram(&sMetrics, "frame_ns", true),
+      nUpdateMetric = metrics_histogram(&sMetrics, "update_ns", true),
+      nOutputMetric = metrics_histogram(&sMetrics, "output_ns", true),
+      nInputMetric = metrics_histogram(&sMetrics, "input_ns", true),
+      nCellsMetric = metrics_histogram(&sMetrics, "cells", false),
+      nBytesMetric = metrics_histogram(&sMetrics, "bytes", false),
+      nWritesMetric = metrics_counter(&sMetrics, "writes");
 
   setlocale(LC_ALL, "");
 
@@ -39,11 +169,49 @@ int main(int argc, char *argv[], char **envp) {
 
   getmaxyx(stdscr, nYmax, nXmax);
 
-  wchar_t pixels[] = {L' ', L'\u2591', L'\u2592', L'\u2593', L'\u2588'};
+  // ncurses keeps the input, frames bypass it
+  if (bTape) {
+    refresh();
+    bRaw = false;
+    if (tape_resize(&sTape, nYmax, nXmax) == -1) {
+      tape_free(&sTape);
+      endwin();
+      fprintf(stderr, "unable to fit the tape to %dx%d\n", nXmax, nYmax);
+      return 1;
+    }
+  } else if (bRaw) {
+    refresh();
+    // one canvas for all outputs, the local terminal shows its top left
+    if (bWall) {
+      if (wall_open(&sWall, pOutputs, nOutputs, nTiles, nYmax, nXmax,
+                    bSync) == -1) {
+        endwin();
+        fprintf(stderr, "unable to open the outputs\n");
+        return 1;
+      }
+      nYmax = sWall.rows;
+      nXmax = sWall.cols;
+    }
+    bRaw = term_init(&sTerm, STDOUT_FILENO, nYmax, nXmax, bSync) == 0;
+    if (bWall && !bRaw) {
+      wall_close(&sWall);
+      endwin();
+      fprintf(stderr, "unable to allocate the canvas\n");
+      return 1;
+    }
+    // the rows are split in bands, one per thread
+    if (bRaw && nThreads > 1)
+      term_threads(&sTerm, nThreads - 1);
+    if (bRaw && pRecordFile)
+      sTerm.record = &sRecord;
+  }
 
   while (!bFinished) {
 
-    clock_gettime(CLOCK_MONOTONIC_RAW, &sStopTimespec);
+    nStop = metrics_now();
+
+    if (nKey == 'h')
+      sMetrics.hud = !sMetrics.hud;
 
     if (nKey == 'p')
       bPaused = !bPaused;
@@ -51,10 +219,44 @@ int main(int argc, char *argv[], char **envp) {
     if (nKey == 'q')
       bFinished = true;
 
-    if (nKey == KEY_RESIZE)
+    if (nKey == KEY_RESIZE && bWall) {
+      getmaxyx(stdscr, nY, nX);
+      wall_resize(&sWall, nY, nX);
+      refresh();
+    } else if (nKey == KEY_RESIZE) {
       getmaxyx(stdscr, nYmax, nXmax);
+      if (bTape) {
+        refresh();
+        // the old frame size goes on where the new one does not fit
+        if (tape_resize(&sTape, nYmax, nXmax) == -1) {
+          nYmax = sTape.rows;
+          nXmax = sTape.cols;
+        }
+      } else if (bRaw) {
+        refresh();
+        term_resize(&sTerm, nYmax, nXmax);
+      }
+    }
+
+    if (bTape) {
+
+      tape_begin(&sTape);
 
-    if (!bPaused) {
+      // a paused frame repeats the rows, so the text is drawn on them again
+      tape_rows(&sTape, bPaused);
+    } else if (!bPaused && bHalf) {
+
+      for (nY = 0; nY < 2 * nYmax; nY++)
+        for (nX = 0; nX < nXmax; nX++)
+          term_plot(&sTerm, nY, nX, dots[rand() % 2]);
+
+      term_halfblocks(&sTerm);
+    } else if (!bPaused && bRaw) {
+
+      for (nY = 0; nY < nYmax; nY++)
+        for (nX = 0; nX < nXmax; nX++)
+          term_put(&sTerm, nY, nX, pixels[rand() % 5]);
+    } else if (!bPaused) {
 
       erase();
 
@@ -62,18 +264,87 @@ int main(int argc, char *argv[], char **envp) {
         printw("%lc", pixels[rand() % 5]);
     }
 
-    fMicroSeconds =
-        (float)(sStopTimespec.tv_sec - sStartTimespec.tv_sec) * 1000000.0f +
-        (float)(sStopTimespec.tv_nsec - sStartTimespec.tv_nsec) / 1000.0f;
+    nUpdated = metrics_now();
+
+    nFrameNs = nStart ? nStop - nStart : 0;
+
+    if (bTape)
+      tape_printw(&sTape, nYmax - 1, "FPS: %0.2f",
+                  nFrameNs ? 1e9 / nFrameNs : 0.0);
+    else if (bRaw)
+      term_printw(&sTerm, nYmax - 1, 0, "FPS: %0.2f",
+                  nFrameNs ? 1e9 / nFrameNs : 0.0);
+    else
+      mvprintw(nYmax - 1, 0, "FPS: %0.2f", nFrameNs ? 1e9 / nFrameNs : 0.0);
+
+    if (sMetrics.hud) {
+      char sLine[METRICSLINE];
+      for (int i = 0; metrics_hud(&sMetrics, i, sLine, METRICSLINE); i++)
+        if (bTape)
+          tape_printw(&sTape, i, "%s", sLine);
+        else if (bRaw)
+          term_printw(&sTerm, i, 0, "%s", sLine);
+        else
+          mvprintw(i, 0, "%s", sLine);
+    }
 
-    mvprintw(nYmax - 1, 0, "FPS: %0.2f", 1000000.0f / fMicroSeconds);
+    nComposed = metrics_now();
 
-    nKey = getch(); // calls refresh
+    if (bTape) {
+      metrics_observe(&sMetrics, nBytesMetric,
+                      tape_send(&sTape, STDOUT_FILENO));
+      metrics_observe(&sMetrics, nCellsMetric, (uint64_t)nYmax * nXmax);
+      metrics_add(&sMetrics, nWritesMetric, 1);
+    } else if (bRaw) {
+      metrics_observe(&sMetrics, nBytesMetric,
+                      bWall ? wall_frame(&sWall, &sTerm) : term_frame(&sTerm));
+      metrics_observe(&sMetrics, nCellsMetric, sTerm.cells);
+      metrics_add(&sMetrics, nWritesMetric, sTerm.writes);
+    } else
+      refresh();
 
-    sStartTimespec = sStopTimespec;
+    nOutput = metrics_now();
+
+    nKey = getch();
+
+    nInput = metrics_now();
+
+    allocguard_frame();
+
+    if (nFrameNs)
+      metrics_observe(&sMetrics, nFrameMetric, nFrameNs);
+    metrics_observe(&sMetrics, nUpdateMetric, nUpdated - nStop);
+    metrics_observe(&sMetrics, nOutputMetric, nOutput - nUpdated);
+    metrics_observe(&sMetrics, nInputMetric, nInput - nOutput);
+
+    trace_span("simulate", nStop, nUpdated);
+    trace_span("compose", nUpdated, nComposed);
+    trace_span("flush", nComposed, nOutput);
+    trace_span("input", nOutput, nInput);
+
+    metrics_tick(&sMetrics, nStop);
+
+    nStart = nStop;
   }
 
+  if (bWall)
+    wall_close(&sWall);
+
   endwin();
 
+  if (bRaw)
+    term_free(&sTerm);
+
+  if (bTape)
+    tape_free(&sTape);
+
+  if (pRecordFile)
+    record_close(&sRecord);
+
+  metrics_free(&sMetrics);
+
+  if (pTraceFile)
+    trace_close();
+
   return 0;
 }
@@ -0,0 +1,163 @@
+/**
+ *  @file   tape.c
+ *  @brief  Frames Sampled from Pre-Encoded Noise
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "tape.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int tape_init(struct tape *tape, size_t size, const wchar_t *glyphs,
+              int nglyphs, short fg, bool sync) {
+
+  memset(tape, 0, sizeof(struct tape));
+
+  tape->fg = fg;
+  tape->sync = sync;
+
+  if (arena_init(&tape->arena, size) == -1)
+    return (-1);
+
+  // half the size each way
+  tape->ncells = size / TAPECELLBYTES / 2;
+  tape->cells =
+      (char *)arena_alloc(&tape->arena, 2 * tape->ncells * TAPECELLBYTES);
+  tape->mirror = tape->cells + tape->ncells * TAPECELLBYTES;
+
+  char *p = tape->cells;
+  for (size_t i = 0; i < tape->ncells; i++) {
+    wchar_t ch = glyphs[rand() % nglyphs];
+    *p++ = 0xe0 | (ch >> 12);
+    *p++ = 0x80 | ((ch >> 6) & 0x3f);
+    *p++ = 0x80 | (ch & 0x3f);
+  }
+
+  for (size_t i = 0; i < tape->ncells; i++)
+    memcpy(tape->mirror + i * TAPECELLBYTES,
+           tape->cells + (tape->ncells - 1 - i) * TAPECELLBYTES,
+           TAPECELLBYTES);
+
+  return (0);
+}
+
+void tape_free(struct tape *tape) {
+
+  arena_free(&tape->arena);
+  free(tape->out);
+  tape->out = NULL;
+}
+
+int tape_resize(struct tape *tape, int rows, int cols) {
+
+  if (rows < 1 || cols < 1 || (size_t)cols > tape->ncells)
+    return (-1);
+
+  size_t out_size = (size_t)rows * (cols * TAPECELLBYTES + 2) + TAPEEXTRA;
+
+  char *out = (char *)realloc(tape->out, out_size);
+  if (out == NULL)
+    return (-1);
+
+  tape->out = out;
+  tape->out_size = out_size;
+  tape->rows = rows;
+  tape->cols = cols;
+  tape->p = out;
+
+  return (0);
+}
+
+void tape_begin(struct tape *tape) {
+
+  tape->p = tape->out;
+
+  if (tape->sync)
+    tape->p = stpcpy(tape->p, "\33[?2026h");
+}
+
+// rows follow each other, so only the first needs an address; the mirror of
+// the cells at offset starts where they end, counted from the back
+void tape_rows(struct tape *tape, bool again) {
+
+  size_t row = (size_t)tape->cols * TAPECELLBYTES,
+         offsets = tape->ncells - tape->cols + 1;
+  char *p = stpcpy(tape->p, "\33[H");
+
+  if (!again)
+    tape->seed = rand();
+
+  unsigned int state = tape->seed;
+
+  if (tape->fg >= 0)
+    p += sprintf(p, "\33[38;5;%dm", tape->fg);
+
+  for (int y = 0; y < tape->rows; y++) {
+    if (y > 0) {
+      *p++ = '\r';
+      *p++ = '\n';
+    }
+    size_t offset = (size_t)rand_r(&state) % offsets;
+    if (rand_r(&state) & 1)
+      memcpy(p, tape->mirror + (offsets - 1 - offset) * TAPECELLBYTES, row);
+    else
+      memcpy(p, tape->cells + offset * TAPECELLBYTES, row);
+    p += row;
+  }
+
+  if (tape->fg >= 0)
+    p = stpcpy(p, "\33[m");
+
+  tape->p = p;
+}
+
+void tape_printw(struct tape *tape, int y, const char *fmt, ...) {
+
+  char *end = tape->out + tape->out_size - 16;
+  va_list args;
+
+  if (y < 0 || y >= tape->rows || end - tape->p < 16)
+    return;
+
+  tape->p += sprintf(tape->p, "\33[%dH", y + 1);
+
+  va_start(args, fmt);
+  int len = vsnprintf(tape->p, end - tape->p, fmt, args);
+  va_end(args);
+
+  // a line of text is cut off at the edge
+  if (len > tape->cols)
+    len = tape->cols;
+  if (len > end - tape->p - 1)
+    len = end - tape->p - 1;
+
+  tape->p += len;
+}
+
+size_t tape_send(struct tape *tape, int fd) {
+
+  if (tape->sync)
+    tape->p = stpcpy(tape->p, "\33[?2026l");
+
+  size_t done = 0, len = tape->p - tape->out;
+
+  while (done < len) {
+    ssize_t n = write(fd, tape->out + done, len - done);
+    if (n == -1) {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+      break;
+    }
+    done += n;
+  }
+
+  return (done);
+}
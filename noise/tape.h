@@ -0,0 +1,52 @@
+/**
+ *  @file   tape.h
+ *  @brief  Frames Sampled from Pre-Encoded Noise
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef TAPE_H_
+#define TAPE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <wchar.h>
+
+#include "arena.h"
+
+#define TAPECELLBYTES 3
+#define TAPEEXTRA 4096
+
+// random glyphs, UTF-8 encoded once into a single mapping; every glyph takes
+// TAPECELLBYTES, so a row starting at any cell of the tape is a copy away;
+// the run is followed by its mirror image, so a flipped row is one as well
+struct tape {
+  struct arena arena;
+  char *cells, *mirror;
+  size_t ncells;
+  char *out, *p;
+  size_t out_size;
+  int rows, cols;
+  unsigned int seed; // of the offsets of the last rows
+  short fg;
+  bool sync;
+};
+
+// size in bytes, glyphs in U+0800 to U+FFFF, fg an xterm colour or -1
+int tape_init(struct tape *tape, size_t size, const wchar_t *glyphs,
+              int nglyphs, short fg, bool sync);
+void tape_free(struct tape *tape);
+
+int tape_resize(struct tape *tape, int rows, int cols);
+
+// a frame is begun, filled with rows from random offsets, each flipped or
+// not, or those of the frame before when again, drawn over and sent; returns
+// the bytes written
+void tape_begin(struct tape *tape);
+void tape_rows(struct tape *tape, bool again);
+void tape_printw(struct tape *tape, int y, const char *fmt, ...);
+size_t tape_send(struct tape *tape, int fd);
+
+#endif // TAPE_H_
@@ -0,0 +1,249 @@
+/**
+ *  @file   replay.c
+ *  @brief  Replay of Recorded Frames in Ncurses
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include <locale.h>
+#include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "allocguard.h"
+#include "metrics.h"
+#include "record.h"
+#include "term.h"
+
+#define SEEK 5000000000ull
+
+uint64_t now() {
+
+  struct timespec sTimespec;
+
+  clock_gettime(CLOCK_MONOTONIC, &sTimespec);
+
+  return (uint64_t)sTimespec.tv_sec * 1000000000 + sTimespec.tv_nsec;
+}
+
+// recorded cells outside the terminal are cut off
+void show(struct term *pTerm, struct replay *pReplay,
+          struct metrics *pMetrics) {
+
+  int nRows = pReplay->rows < pTerm->rows ? pReplay->rows : pTerm->rows,
+      nCols = pReplay->cols < pTerm->cols ? pReplay->cols : pTerm->cols;
+
+  term_erase(pTerm);
+
+  for (int y = 0; y < nRows; y++)
+    for (int x = 0; x < nCols; x++)
+      pTerm->back[y * pTerm->cols + x] =
+          pReplay->cells[y * pReplay->cols + x];
+
+  if (pMetrics->hud) {
+    char sLine[METRICSLINE];
+    for (int i = 0; metrics_hud(pMetrics, i, sLine, METRICSLINE); i++)
+      term_printw(pTerm, i, 0, "%s", sLine);
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  int nXmax = 0, nYmax = 0, nKey = ERR, nOpt, nWait;
+
+  bool bFinished = false, bPaused = false, bFast = false, bBench = false,
+       bSync = false, bPending = false, bEnd = false;
+
+  double fStart = 0.0;
+
+  char *pMetricsTarget = NULL;
+
+  struct metrics sMetrics;
+
+  while ((nOpt = getopt(argc, argv, "be:fs:S")) != -1) {
+    switch (nOpt) {
+    case 'b':
+      bBench = true;
+      bFast = true;
+      break;
+    case 'f':
+      bFast = true;
+      break;
+    case 'e':
+      pMetricsTarget = optarg;
+      break;
+    case 's':
+      fStart = atof(optarg);
+      break;
+    case 'S':
+      bSync = true;
+      break;
+    default:
+      fprintf(stderr,
+              "usage: %s [-b] [-e target] [-f] [-s seconds] [-S] file\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (optind >= argc) {
+    fprintf(stderr, "missing file\n");
+    return 1;
+  }
+
+  struct replay sReplay;
+
+  if (replay_open(&sReplay, argv[optind]) == -1) {
+    fprintf(stderr, "unable to replay %s\n", argv[optind]);
+    return 1;
+  }
+
+  if (metrics_init(&sMetrics, "replay", pMetricsTarget) == -1) {
+    replay_close(&sReplay);
+    fprintf(stderr, "unable to export metrics to %s\n", pMetricsTarget);
+    return 1;
+  }
+
+  int nOutputMetric = metrics_histogram(&sMetrics, "output_ns", true),
+      nCellsMetric = metrics_histogram(&sMetrics, "cells", false),
+      nBytesMetric = metrics_histogram(&sMetrics, "bytes", false),
+      nWritesMetric = metrics_counter(&sMetrics, "writes");
+
+  setlocale(LC_ALL, "");
+
+  initscr();
+
+  noecho();
+
+  cbreak();
+
+  curs_set(false);
+
+  keypad(stdscr, true);
+
+  getmaxyx(stdscr, nYmax, nXmax);
+
+  // ncurses keeps the input, frames bypass it
+  refresh();
+
+  struct term sTerm;
+
+  if (term_init(&sTerm, STDOUT_FILENO, nYmax, nXmax, bSync) == -1) {
+    endwin();
+    replay_close(&sReplay);
+    fprintf(stderr, "unable to allocate frame buffers\n");
+    return 1;
+  }
+
+  if (fStart > 0.0 && replay_seek(&sReplay, fStart * 1e9) == 1) {
+    show(&sTerm, &sReplay, &sMetrics);
+    term_frame(&sTerm);
+  }
+
+  // wall clock time of the start of the recording
+  uint64_t nBase = now() - sReplay.ns, nBegin = now(), nTarget;
+
+  size_t nBytes = 0;
+
+  unsigned long nFrames = 0;
+
+  while (!bFinished) {
+
+    if (!bPaused && !bPending && !bEnd) {
+      if (replay_next(&sReplay) == 1)
+        bPending = true;
+      else if (bBench)
+        break;
+      else
+        bEnd = true;
+    }
+
+    nWait = -1;
+
+    if (bPending && !bPaused) {
+      uint64_t nDue = nBase + sReplay.ns, nNow = now();
+      if (bFast || nNow >= nDue) {
+        show(&sTerm, &sReplay, &sMetrics);
+        size_t nFrameBytes = term_frame(&sTerm);
+        metrics_observe(&sMetrics, nOutputMetric, now() - nNow);
+        metrics_observe(&sMetrics, nBytesMetric, nFrameBytes);
+        metrics_observe(&sMetrics, nCellsMetric, sTerm.cells);
+        metrics_add(&sMetrics, nWritesMetric, sTerm.writes);
+        metrics_tick(&sMetrics, nNow);
+        nBytes += nFrameBytes;
+        ++nFrames;
+        bPending = false;
+        nWait = 0;
+      } else
+        nWait = (nDue - nNow) / 1000000;
+    }
+
+    timeout(nWait);
+
+    nKey = getch();
+
+    allocguard_frame();
+
+    switch (nKey) {
+    case 'q':
+      bFinished = true;
+      break;
+    case 'p':
+      bPaused = !bPaused;
+      nBase = now() - sReplay.ns;
+      break;
+    case 'f':
+      bFast = !bFast;
+      nBase = now() - sReplay.ns;
+      break;
+    case 'h':
+      sMetrics.hud = !sMetrics.hud;
+      break;
+    case KEY_LEFT:
+    case KEY_RIGHT:
+    case KEY_HOME:
+      if (nKey == KEY_HOME || (nKey == KEY_LEFT && sReplay.ns < SEEK))
+        nTarget = 0;
+      else if (nKey == KEY_LEFT)
+        nTarget = sReplay.ns - SEEK;
+      else
+        nTarget = sReplay.ns + SEEK;
+      if (replay_seek(&sReplay, nTarget) == 1) {
+        show(&sTerm, &sReplay, &sMetrics);
+        term_frame(&sTerm);
+      }
+      nBase = now() - sReplay.ns;
+      bPending = bEnd = false;
+      break;
+    case KEY_RESIZE:
+      getmaxyx(stdscr, nYmax, nXmax);
+      refresh();
+      term_resize(&sTerm, nYmax, nXmax);
+      show(&sTerm, &sReplay, &sMetrics);
+      term_frame(&sTerm);
+      break;
+    }
+  }
+
+  double fSeconds = (now() - nBegin) / 1e9;
+
+  endwin();
+
+  term_free(&sTerm);
+
+  replay_close(&sReplay);
+
+  metrics_free(&sMetrics);
+
+  if (bBench && nFrames > 0)
+    printf("%lu frames, %zu bytes in %.3f s: %.1f us and %zu bytes per "
+           "frame\n",
+           nFrames, nBytes, fSeconds, fSeconds * 1e6 / nFrames,
+           nBytes / nFrames);
+
+  return 0;
+}
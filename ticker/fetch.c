@@ -0,0 +1,520 @@
+/**
+ *  @file   fetch.c
+ *  @brief  Keep-Alive HTTP Fetcher for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#define _GNU_SOURCE
+
+#include "fetch.h"
+#include "trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define FETCHCHUNK 16384
+#define FETCHMAXHEADER 65536
+
+int fetch_init(struct fetcher *fetcher) {
+
+  memset(fetcher, 0, sizeof(struct fetcher));
+
+  for (int i = 0; i < FETCHMAXCONN; i++)
+    fetcher->conns[i].fd = -1;
+
+  fetcher->resolver = resolve_create();
+  if (fetcher->resolver == NULL)
+    return (-1);
+
+  return (0);
+}
+
+static void fetch_close(struct conn *conn) {
+
+  if (conn->fd != -1)
+    close(conn->fd);
+  conn->fd = -1;
+  conn->busy = false;
+  conn->host[0] = '\0';
+}
+
+void fetch_free(struct fetcher *fetcher) {
+
+  for (int i = 0; i < FETCHMAXCONN; i++)
+    fetch_close(&fetcher->conns[i]);
+
+  for (int i = 0; i < fetcher->nrequests; i++) {
+    arena_free(&fetcher->requests[i]->arena);
+    fetcher->requests[i]->buf = NULL;
+  }
+
+  resolve_destroy(fetcher->resolver);
+}
+
+int fetch_add(struct fetcher *fetcher, struct request *request,
+              const char *url) {
+
+  if (fetcher->nrequests == FETCHMAXREQ)
+    return (-1);
+
+  memset(request, 0, sizeof(struct request));
+
+  if (strncasecmp(url, "http://", 7) == 0)
+    url += 7;
+  else if (strstr(url, "://") != NULL)
+    return (-1);
+
+  size_t hostlen = strcspn(url, ":/");
+  if (hostlen == 0 || hostlen >= RESOLVEHOST)
+    return (-1);
+  memcpy(request->host, url, hostlen);
+  request->host[hostlen] = '\0';
+  url += hostlen;
+
+  request->port = 80;
+  if (*url == ':') {
+    request->port = (int)strtol(url + 1, (char **)&url, 10);
+    if (request->port <= 0 || request->port > 65535)
+      return (-1);
+  }
+
+  if (*url == '\0')
+    url = "/";
+  if (*url != '/' || strlen(url) >= FETCHPATH)
+    return (-1);
+  strcpy(request->path, url);
+
+  if (arena_init(&request->arena, FETCHMAXBODY) == -1)
+    return (-1);
+  request->buf = request->arena.base;
+  request->cap = request->arena.size;
+
+  request->state = FETCH_IDLE;
+  fetcher->requests[fetcher->nrequests++] = request;
+
+  return (0);
+}
+
+static void fetch_fail(struct request *request) {
+
+  if (request->conn != NULL) {
+    fetch_close(request->conn);
+    request->conn = NULL;
+  }
+  request->state = FETCH_FAILED;
+}
+
+static void fetch_reset(struct request *request) {
+
+  request->body = request->raw = request->end = request->sent = 0;
+  request->chunked = request->trailer = false;
+  request->keep_alive = true;
+  request->content_length = -1;
+  request->chunk_left = 0;
+}
+
+// a pooled connection the server already dropped gets one fresh attempt
+static bool fetch_retry(struct request *request) {
+
+  if (!request->reused || request->retries > 0 || request->end > 0)
+    return (false);
+
+  fetch_close(request->conn);
+  request->conn = NULL;
+  ++request->retries;
+  fetch_reset(request);
+  request->state = FETCH_RESOLVING;
+
+  return (true);
+}
+
+static void fetch_done(struct request *request) {
+
+  request->buf[request->body] = '\0';
+  request->state = FETCH_DONE;
+
+  struct conn *conn = request->conn;
+  request->conn = NULL;
+  if (request->keep_alive &&
+      (request->chunked || request->content_length >= 0)) {
+    conn->busy = false;
+    conn->since = time(NULL);
+  } else
+    fetch_close(conn);
+}
+
+static void fetch_connect(struct fetcher *fetcher, struct request *request) {
+
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+
+  int status = resolve_lookup(fetcher->resolver, request->host, request->port,
+                              &addr, &addrlen);
+  if (status == 0) {
+    request->state = FETCH_RESOLVING;
+    return;
+  }
+  if (status == -1) {
+    fetch_fail(request);
+    return;
+  }
+
+  struct conn *slot = NULL, *idle = NULL;
+  for (int i = 0; i < FETCHMAXCONN; i++) {
+    struct conn *conn = &fetcher->conns[i];
+    if (conn->fd != -1 && conn->port == request->port &&
+        strcmp(conn->host, request->host) == 0) {
+      // requests to one host queue up behind its connection
+      if (conn->busy) {
+        request->state = FETCH_WAITING;
+        return;
+      }
+      conn->busy = true;
+      request->conn = conn;
+      request->reused = true;
+      request->state = FETCH_SENDING;
+      return;
+    }
+    if (conn->fd == -1) {
+      if (slot == NULL)
+        slot = conn;
+    } else if (!conn->busy && (idle == NULL || conn->since < idle->since))
+      idle = conn;
+  }
+
+  if (slot == NULL && idle != NULL) {
+    fetch_close(idle);
+    slot = idle;
+  }
+  if (slot == NULL) {
+    request->state = FETCH_WAITING;
+    return;
+  }
+
+  int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+  if (fd == -1) {
+    fetch_fail(request);
+    return;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+  slot->fd = fd;
+  slot->port = request->port;
+  slot->busy = true;
+  strcpy(slot->host, request->host);
+  request->conn = slot;
+  request->reused = false;
+
+  if (connect(fd, (struct sockaddr *)&addr, addrlen) == 0)
+    request->state = FETCH_SENDING;
+  else if (errno == EINPROGRESS)
+    request->state = FETCH_CONNECTING;
+  else
+    fetch_fail(request);
+}
+
+static void fetch_parse_headers(struct request *request) {
+
+  char *buf = request->buf, *eoh = memmem(buf, request->end, "\r\n\r\n", 4);
+
+  if (eoh == NULL) {
+    if (request->end > FETCHMAXHEADER)
+      fetch_fail(request);
+    return;
+  }
+  *eoh = '\0';
+
+  int minor, status;
+  if (sscanf(buf, "HTTP/1.%d %d", &minor, &status) != 2 || status != 200) {
+    fetch_fail(request);
+    return;
+  }
+  request->keep_alive = minor > 0;
+
+  for (char *line = strstr(buf, "\r\n"), *next; line != NULL; line = next) {
+    line += 2;
+    if ((next = strstr(line, "\r\n")) != NULL)
+      *next = '\0';
+    if (strncasecmp(line, "Content-Length:", 15) == 0)
+      request->content_length = strtol(line + 15, NULL, 10);
+    else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0)
+      request->chunked = strcasestr(line, "chunked") != NULL;
+    else if (strncasecmp(line, "Connection:", 11) == 0) {
+      if (strcasestr(line, "close") != NULL)
+        request->keep_alive = false;
+      else if (strcasestr(line, "keep-alive") != NULL)
+        request->keep_alive = true;
+    }
+  }
+
+  size_t start = eoh - buf + 4;
+  request->end -= start;
+  memmove(buf, buf + start, request->end);
+  request->state = FETCH_BODY;
+}
+
+static void fetch_parse_body(struct request *request) {
+
+  char *buf = request->buf;
+
+  if (!request->chunked) {
+    request->body = request->end;
+    if (request->content_length >= 0 &&
+        request->body >= (size_t)request->content_length) {
+      request->body = request->content_length;
+      fetch_done(request);
+    }
+    return;
+  }
+
+  // chunked: decode in place, data moves down over the chunk headers
+  while (request->raw < request->end) {
+    if (request->chunk_left > 0) {
+      size_t n = request->end - request->raw;
+      if (n > request->chunk_left)
+        n = request->chunk_left;
+      memmove(buf + request->body, buf + request->raw, n);
+      request->body += n;
+      request->raw += n;
+      request->chunk_left -= n;
+      continue;
+    }
+    char *eol =
+        memmem(buf + request->raw, request->end - request->raw, "\r\n", 2);
+    if (eol == NULL)
+      break;
+    char *line = buf + request->raw;
+    bool empty = eol == line;
+    request->raw = eol - buf + 2;
+    if (request->trailer) {
+      if (empty) {
+        fetch_done(request);
+        return;
+      }
+    } else if (!empty) {
+      request->chunk_left = strtoul(line, NULL, 16);
+      if (request->chunk_left == 0)
+        request->trailer = true;
+    }
+  }
+}
+
+static void fetch_receive(struct request *request) {
+
+  for (;;) {
+    if (request->cap - request->end < FETCHCHUNK) {
+      fetch_fail(request);
+      return;
+    }
+
+    ssize_t n = recv(request->conn->fd, request->buf + request->end,
+                     request->cap - request->end - 1, 0);
+    if (n > 0) {
+      request->end += n;
+      if (request->state == FETCH_HEADERS)
+        fetch_parse_headers(request);
+      if (request->state == FETCH_BODY)
+        fetch_parse_body(request);
+      if (request->state != FETCH_HEADERS && request->state != FETCH_BODY)
+        return;
+      continue;
+    }
+    if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (n == -1 && errno == EINTR)
+      continue;
+    // closed by the server
+    if (n == 0 && request->state == FETCH_BODY && !request->chunked &&
+        request->content_length < 0) {
+      request->keep_alive = false;
+      fetch_done(request);
+    } else if (!fetch_retry(request))
+      fetch_fail(request);
+    return;
+  }
+}
+
+static void fetch_send(struct request *request) {
+
+  char msg[FETCHPATH + RESOLVEHOST + 128], port[16] = "";
+
+  if (request->port != 80)
+    snprintf(port, sizeof(port), ":%d", request->port);
+
+  int len = snprintf(msg, sizeof(msg),
+                     "GET %s HTTP/1.1\r\nHost: %s%s\r\nUser-Agent: ticker\r\n"
+                     "Accept-Encoding: identity\r\nConnection: keep-alive\r\n"
+                     "\r\n",
+                     request->path, request->host, port);
+
+  while (request->sent < (size_t)len) {
+    ssize_t n = send(request->conn->fd, msg + request->sent,
+                     len - request->sent, MSG_NOSIGNAL);
+    if (n == -1) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return;
+      if (!fetch_retry(request))
+        fetch_fail(request);
+      return;
+    }
+    request->sent += n;
+  }
+
+  request->state = FETCH_HEADERS;
+}
+
+static void fetch_step(struct fetcher *fetcher, struct request *request,
+                       bool readable, bool writable) {
+
+  for (;;) {
+    enum fetch_state state = request->state;
+
+    switch (state) {
+    case FETCH_RESOLVING:
+    case FETCH_WAITING:
+      fetch_connect(fetcher, request);
+      break;
+    case FETCH_CONNECTING: {
+      if (!writable)
+        return;
+      int error = 0;
+      socklen_t len = sizeof(int);
+      getsockopt(request->conn->fd, SOL_SOCKET, SO_ERROR, &error, &len);
+      if (error != 0)
+        fetch_fail(request);
+      else
+        request->state = FETCH_SENDING;
+      break;
+    }
+    case FETCH_SENDING:
+      fetch_send(request);
+      break;
+    case FETCH_HEADERS:
+    case FETCH_BODY:
+      if (readable)
+        fetch_receive(request);
+      return;
+    default:
+      return;
+    }
+
+    // stop once a state has to wait for the network
+    if (request->state == state)
+      return;
+  }
+}
+
+void fetch_start(struct fetcher *fetcher, struct request *request) {
+
+  fetch_reset(request);
+  request->retries = 0;
+  request->deadline = time(NULL) + FETCHTIMEOUT;
+  request->state = FETCH_RESOLVING;
+
+  fetch_step(fetcher, request, false, false);
+}
+
+int fetch_fds(struct fetcher *fetcher, fd_set *readfds, fd_set *writefds,
+              int maxfd, time_t *timeout) {
+
+  time_t now = time(NULL);
+
+  FD_SET(resolve_fd(fetcher->resolver), readfds);
+  if (resolve_fd(fetcher->resolver) > maxfd)
+    maxfd = resolve_fd(fetcher->resolver);
+
+  for (int i = 0; i < FETCHMAXCONN; i++) {
+    struct conn *conn = &fetcher->conns[i];
+    if (conn->fd == -1 || conn->busy)
+      continue;
+    // idle connections are watched so a server-side close is noticed
+    FD_SET(conn->fd, readfds);
+    if (conn->fd > maxfd)
+      maxfd = conn->fd;
+    time_t left = conn->since + FETCHIDLE - now;
+    if (left < *timeout)
+      *timeout = left < 0 ? 0 : left;
+  }
+
+  for (int i = 0; i < fetcher->nrequests; i++) {
+    struct request *request = fetcher->requests[i];
+    if (request->state == FETCH_IDLE || request->state == FETCH_DONE ||
+        request->state == FETCH_FAILED)
+      continue;
+    time_t left = request->deadline - now;
+    if (left < *timeout)
+      *timeout = left < 0 ? 0 : left;
+    if (request->conn == NULL)
+      continue;
+    int fd = request->conn->fd;
+    if (request->state == FETCH_CONNECTING || request->state == FETCH_SENDING)
+      FD_SET(fd, writefds);
+    else
+      FD_SET(fd, readfds);
+    if (fd > maxfd)
+      maxfd = fd;
+  }
+
+  return (maxfd);
+}
+
+void fetch_process(struct fetcher *fetcher, fd_set *readfds,
+                   fd_set *writefds) {
+
+  TRACE("fetch");
+
+  time_t now = time(NULL);
+
+  if (FD_ISSET(resolve_fd(fetcher->resolver), readfds))
+    resolve_clear(fetcher->resolver);
+
+  for (int i = 0; i < FETCHMAXCONN; i++) {
+    struct conn *conn = &fetcher->conns[i];
+    if (conn->fd == -1 || conn->busy)
+      continue;
+    if (now - conn->since >= FETCHIDLE) {
+      fetch_close(conn);
+      continue;
+    }
+    if (FD_ISSET(conn->fd, readfds)) {
+      char byte;
+      if (recv(conn->fd, &byte, 1, MSG_PEEK) != -1 ||
+          (errno != EAGAIN && errno != EWOULDBLOCK))
+        fetch_close(conn);
+    }
+  }
+
+  // connections first, queued requests may then pick up freed ones
+  for (int pass = 0; pass < 2; pass++)
+    for (int i = 0; i < fetcher->nrequests; i++) {
+      struct request *request = fetcher->requests[i];
+      bool queued = request->state == FETCH_RESOLVING ||
+                    request->state == FETCH_WAITING;
+      if (request->state == FETCH_IDLE || request->state == FETCH_DONE ||
+          request->state == FETCH_FAILED || queued != (pass == 1))
+        continue;
+      if (now >= request->deadline) {
+        fetch_fail(request);
+        continue;
+      }
+      int fd = request->conn ? request->conn->fd : -1;
+      fetch_step(fetcher, request, fd != -1 && FD_ISSET(fd, readfds),
+                 fd != -1 && FD_ISSET(fd, writefds));
+    }
+}
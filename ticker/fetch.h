@@ -0,0 +1,87 @@
+/**
+ *  @file   fetch.h
+ *  @brief  Keep-Alive HTTP Fetcher for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef FETCH_H_
+#define FETCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/select.h>
+#include <time.h>
+
+#include "arena.h"
+#include "resolve.h"
+
+#define FETCHMAXCONN 16
+#define FETCHMAXREQ 64
+#define FETCHTIMEOUT 30
+#define FETCHIDLE 60
+#define FETCHMAXBODY (8 << 20)
+#define FETCHPATH 1024
+
+enum fetch_state {
+  FETCH_IDLE,
+  FETCH_RESOLVING,
+  FETCH_WAITING,
+  FETCH_CONNECTING,
+  FETCH_SENDING,
+  FETCH_HEADERS,
+  FETCH_BODY,
+  FETCH_DONE,
+  FETCH_FAILED
+};
+
+// one connection per host, reused across requests while the server allows
+struct conn {
+  int fd, port;
+  char host[RESOLVEHOST];
+  bool busy;
+  time_t since;
+};
+
+struct request {
+  char host[RESOLVEHOST], path[FETCHPATH];
+  int port;
+  enum fetch_state state;
+  struct conn *conn;
+  bool reused, chunked, keep_alive, trailer;
+  int retries;
+  long content_length;
+  size_t chunk_left, sent;
+  time_t deadline;
+  // response: body is the decoded length, raw/end delimit unparsed bytes;
+  // buf is the whole arena, only the pages a response touches are backed
+  struct arena arena;
+  char *buf;
+  size_t cap, body, raw, end;
+};
+
+struct fetcher {
+  struct resolver *resolver;
+  struct conn conns[FETCHMAXCONN];
+  struct request *requests[FETCHMAXREQ];
+  int nrequests;
+};
+
+int fetch_init(struct fetcher *fetcher);
+void fetch_free(struct fetcher *fetcher);
+
+// accepts [http://]host[:port][/path]
+int fetch_add(struct fetcher *fetcher, struct request *request,
+              const char *url);
+
+void fetch_start(struct fetcher *fetcher, struct request *request);
+
+// select() plumbing; timeout is lowered to the nearest request deadline
+int fetch_fds(struct fetcher *fetcher, fd_set *readfds, fd_set *writefds,
+              int maxfd, time_t *timeout);
+void fetch_process(struct fetcher *fetcher, fd_set *readfds,
+                   fd_set *writefds);
+
+#endif // FETCH_H_
@@ -0,0 +1,331 @@
+/**
+ *  @file   index.c
+ *  @brief  Inverted Headline Index for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "index.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#define INDEXSLOTS 4096
+#define INDEXPOSTING 4
+
+static inline bool index_char(unsigned char c) {
+  return (isalnum(c) || c >= 0x80);
+}
+
+static inline unsigned char index_fold(unsigned char c) {
+  return (c < 0x80 ? tolower(c) : c);
+}
+
+int index_init(struct index *index, size_t history) {
+
+  memset(index, 0, sizeof(struct index));
+
+  if (arena_init(&index->arena, INDEXRATIO * history) == -1 ||
+      arena_init(&index->keys_arena, history) == -1) {
+    index_free(index);
+    return (-1);
+  }
+
+  index_reset(index);
+
+  return (0);
+}
+
+void index_reset(struct index *index) {
+
+  // keys are packed without the arena keeping count
+  index->keys_arena.peak = index->keys_used;
+  arena_trim(&index->arena);
+  arena_trim(&index->keys_arena);
+  memset(index->free, 0, sizeof(index->free));
+
+  index->nslots = INDEXSLOTS;
+  index->nused = 0;
+  index->slots = (struct slot *)arena_alloc(
+      &index->arena, index->nslots * sizeof(struct slot));
+  memset(index->slots, 0, index->nslots * sizeof(struct slot));
+  index->keys_size = index->keys_arena.size;
+  index->keys = index->keys_arena.base;
+  index->keys_used = 0;
+  index->dropped = 0;
+}
+
+bool index_full(const struct index *index) {
+
+  // the doubled table must still fit next to the current one
+  size_t grown = index->nslots * 2 * sizeof(struct slot);
+
+  return (index->arena.used > index->arena.size / 100 * INDEXHIGHWATER ||
+          index->arena.used + grown > index->arena.size ||
+          index->keys_used > index->keys_size / 100 * INDEXHIGHWATER);
+}
+
+void index_free(struct index *index) {
+
+  arena_free(&index->arena);
+  arena_free(&index->keys_arena);
+  index->slots = NULL;
+  index->keys = NULL;
+}
+
+int index_token(const char *text, int len, int *pos, int *tok_len) {
+
+  int i = *pos;
+
+  while (i < len && !index_char((unsigned char)text[i]))
+    ++i;
+  if (i == len) {
+    *pos = len;
+    return (-1);
+  }
+
+  int start = i;
+  while (i < len && index_char((unsigned char)text[i]))
+    ++i;
+
+  *pos = i;
+  *tok_len = i - start;
+  return (start);
+}
+
+bool index_same(const char *a, int na, const char *b, int nb) {
+
+  if (na > INDEXMAXTOKEN)
+    na = INDEXMAXTOKEN;
+  if (nb > INDEXMAXTOKEN)
+    nb = INDEXMAXTOKEN;
+  if (na != nb)
+    return (false);
+
+  for (int i = 0; i < na; i++)
+    if (index_fold(a[i]) != index_fold(b[i]))
+      return (false);
+
+  return (true);
+}
+
+static unsigned int index_hash(const char *token, int len) {
+
+  unsigned int hash = 2166136261u;
+
+  for (int i = 0; i < len; i++)
+    hash = (hash ^ index_fold(token[i])) * 16777619u;
+
+  return (hash);
+}
+
+static struct slot *index_find(struct index *index, const char *token,
+                               int len, unsigned int hash) {
+
+  size_t mask = index->nslots - 1;
+
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    struct slot *slot = &index->slots[i];
+    if (slot->len == 0 ||
+        (slot->hash == hash &&
+         index_same(index->keys + slot->key, slot->len, token, len)))
+      return (slot);
+  }
+}
+
+// the old table is only reclaimed by index_reset, it takes as much room as
+// all before it
+static int index_grow(struct index *index) {
+
+  size_t nslots = index->nslots * 2;
+  struct slot *slots = (struct slot *)arena_alloc(
+                  &index->arena, nslots * sizeof(struct slot)),
+              *old = index->slots;
+  if (slots == NULL)
+    return (-1);
+  memset(slots, 0, nslots * sizeof(struct slot));
+
+  for (size_t i = 0; i < index->nslots; i++) {
+    if (old[i].len == 0)
+      continue;
+    size_t j = old[i].hash & (nslots - 1);
+    while (slots[j].len != 0)
+      j = (j + 1) & (nslots - 1);
+    slots[j] = old[i];
+  }
+
+  index->slots = slots;
+  index->nslots = nslots;
+
+  return (0);
+}
+
+static struct slot *index_insert(struct index *index, const char *token,
+                                 int len) {
+
+  if (len > INDEXMAXTOKEN)
+    len = INDEXMAXTOKEN;
+
+  unsigned int hash = index_hash(token, len);
+  struct slot *slot = index_find(index, token, len, hash);
+  if (slot->len != 0)
+    return (slot);
+
+  if ((index->nused + 1) * 10 > index->nslots * 7) {
+    if (index_grow(index) == -1)
+      return (NULL);
+    slot = index_find(index, token, len, hash);
+  }
+
+  if (index->keys_used + len > index->keys_size)
+    return (NULL);
+
+  for (int i = 0; i < len; i++)
+    index->keys[index->keys_used + i] = index_fold(token[i]);
+  slot->hash = hash;
+  slot->key = index->keys_used;
+  slot->len = len;
+  index->keys_used += len;
+  ++index->nused;
+
+  return (slot);
+}
+
+static unsigned int index_lower(struct posting *posting, unsigned long seq) {
+
+  unsigned int lo = 0, hi = posting->n;
+
+  while (lo < hi) {
+    unsigned int mid = (lo + hi) / 2;
+    if (posting->seqs[mid] < seq)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return (lo);
+}
+
+static unsigned long *index_list(struct index *index, unsigned int cap) {
+
+  int class = __builtin_ctz(cap / INDEXPOSTING);
+  unsigned long *list;
+
+  if (class >= INDEXCLASSES)
+    return (NULL);
+
+  if ((list = index->free[class]) != NULL) {
+    index->free[class] = *(unsigned long **)list;
+    return (list);
+  }
+
+  return ((unsigned long *)arena_alloc(&index->arena,
+                                       cap * sizeof(unsigned long)));
+}
+
+static void index_release(struct index *index, unsigned long *list,
+                          unsigned int cap) {
+
+  if (list == NULL)
+    return;
+
+  int class = __builtin_ctz(cap / INDEXPOSTING);
+
+  *(unsigned long **)list = index->free[class];
+  index->free[class] = list;
+}
+
+static int index_append(struct index *index, struct posting *posting,
+                        unsigned long seq, unsigned long first) {
+
+  if (posting->n && posting->seqs[posting->n - 1] == seq)
+    return (0);
+
+  if (posting->n == posting->cap) {
+    unsigned int stale = index_lower(posting, first);
+    if (stale > 0) {
+      posting->n -= stale;
+      memmove(posting->seqs, posting->seqs + stale,
+              posting->n * sizeof(unsigned long));
+    } else {
+      unsigned int cap = posting->cap ? posting->cap * 2 : INDEXPOSTING;
+      unsigned long *seqs = index_list(index, cap);
+      if (seqs == NULL)
+        return (-1);
+      if (posting->n > 0)
+        memcpy(seqs, posting->seqs, posting->n * sizeof(unsigned long));
+      index_release(index, posting->seqs, posting->cap);
+      posting->seqs = seqs;
+      posting->cap = cap;
+    }
+  }
+
+  posting->seqs[posting->n++] = seq;
+
+  return (0);
+}
+
+int index_add(struct index *index, unsigned long seq, const char *text,
+              int len, unsigned long first) {
+
+  int pos = 0, start, tok_len, status = 0;
+
+  while ((start = index_token(text, len, &pos, &tok_len)) != -1) {
+    struct slot *slot = index_insert(index, text + start, tok_len);
+    if (slot == NULL ||
+        index_append(index, &slot->posting, seq, first) == -1) {
+      ++index->dropped;
+      status = -1;
+    }
+  }
+
+  return (status);
+}
+
+int index_query(struct index *index, const char *query, int len,
+                unsigned long first, unsigned long *results, int max) {
+
+  struct posting *lists[INDEXMAXQUERY];
+  int nlists = 0, pos = 0, start, tok_len;
+
+  while (nlists < INDEXMAXQUERY &&
+         (start = index_token(query, len, &pos, &tok_len)) != -1) {
+    if (tok_len > INDEXMAXTOKEN)
+      tok_len = INDEXMAXTOKEN;
+    struct slot *slot = index_find(index, query + start, tok_len,
+                                   index_hash(query + start, tok_len));
+    if (slot->len == 0)
+      return (0);
+    lists[nlists++] = &slot->posting;
+  }
+
+  if (nlists == 0)
+    return (0);
+
+  // drive the intersection from the shortest list
+  for (int i = 1; i < nlists; i++)
+    for (int j = i; j > 0 && lists[j]->n < lists[j - 1]->n; j--) {
+      struct posting *swap = lists[j];
+      lists[j] = lists[j - 1];
+      lists[j - 1] = swap;
+    }
+
+  int nresults = 0;
+  for (unsigned int i = lists[0]->n; i > 0 && nresults < max; i--) {
+    unsigned long seq = lists[0]->seqs[i - 1];
+    if (seq < first)
+      break;
+    int j = 1;
+    for (; j < nlists; j++) {
+      unsigned int k = index_lower(lists[j], seq);
+      if (k == lists[j]->n || lists[j]->seqs[k] != seq)
+        break;
+    }
+    if (j == nlists)
+      results[nresults++] = seq;
+  }
+
+  return (nresults);
+}
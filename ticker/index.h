@@ -0,0 +1,70 @@
+/**
+ *  @file   index.h
+ *  @brief  Inverted Headline Index for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef INDEX_H_
+#define INDEX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+#define INDEXMAXTOKEN 32
+#define INDEXMAXQUERY 8
+#define INDEXCLASSES 24
+#define INDEXHIGHWATER 75 // percent of either arena that calls for a rebuild
+#define INDEXRATIO 16 // tables and postings per byte of history, keys take 1
+
+struct posting {
+  unsigned long *seqs; // ascending, so newest last
+  unsigned int n, cap;
+};
+
+struct slot {
+  unsigned int hash, key, len;
+  struct posting posting;
+};
+
+// open-addressing table of case-folded tokens to headline sequence numbers;
+// tables and postings come from arena, outgrown postings are kept for reuse
+// in free by capacity; neither arena is ever given back piecemeal, so the
+// owner rebuilds the index from the live headlines once index_full
+struct index {
+  struct slot *slots;
+  size_t nslots, nused;
+  char *keys;
+  size_t keys_size, keys_used;
+  struct arena arena, keys_arena;
+  unsigned long *free[INDEXCLASSES];
+  unsigned long dropped; // tokens left out since the last reset
+};
+
+// sized after the history it indexes
+int index_init(struct index *index, size_t history);
+void index_free(struct index *index);
+
+// forget every token, tables and postings start over in the same arenas,
+// whose pages are given back
+void index_reset(struct index *index);
+bool index_full(const struct index *index);
+
+// postings older than first (evicted from the store) are pruned as lists grow;
+// returns -1 when a token did not fit, counted in dropped
+int index_add(struct index *index, unsigned long seq, const char *text,
+               int len, unsigned long first);
+
+// headlines containing every query token, newest first
+int index_query(struct index *index, const char *query, int len,
+                unsigned long first, unsigned long *results, int max);
+
+// next token at or after *pos; returns its start or -1, *pos moves past it
+int index_token(const char *text, int len, int *pos, int *tok_len);
+bool index_same(const char *a, int na, const char *b, int nb);
+
+#endif // INDEX_H_
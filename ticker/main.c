@@ -7,18 +7,16 @@
  *
  ***********************************************/
 
-#include <arpa/inet.h>
 #include <ctype.h>
+#include <errno.h>
 #include <locale.h>
+#define NCURSES_WIDECHAR 1
 #include <ncurses.h>
-#include <netdb.h>
-#include <netinet/in.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/select.h>
-#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -26,6 +24,16 @@
 #include <unistd.h>
 #include <wchar.h>
 
+#include "ring.h"
+#include "allocguard.h"
+#include "fetch.h"
+#include "index.h"
+#include "marquee.h"
+#include "metrics.h"
+#include "store.h"
+#include "trace.h"
+#include "worker.h"
+
 #define READ 0
 #define WRITE 1
 
@@ -40,28 +48,118 @@ typedef struct {
 #define MESGSIZE 512
 #define NMESG 100
 #define INTERVAL 1800
+#define RETRY 60
 #define FIELD 6
+#define HISTORY 16
+#define HISTORYMAX 4096
+#define NRESULTS 256
+#define INDEXSTEP 64
+
+struct search {
+  char query[MESGSIZE];
+  int len, ntokens, tokens[INDEXMAXQUERY][2];
+  unsigned long results[NRESULTS];
+  int nresults, top, shown;
+  bool active, partial;
+};
+
+// queries are answered by live while the other index is rebuilt from the
+// headlines still in the store, INDEXSTEP per wakeup and twice the ones that
+// arrived meanwhile; it is swapped in when it caught up, and the tokens of
+// evicted headlines are only ever dropped that way
+struct indexes {
+  struct index index[2];
+  int live;
+  bool rebuilding;
+  unsigned long next, rebuilt; // headline to add next, store->first then
+  int arrived; // headlines since the last step, which it must outpace
+};
+
+struct feed {
+  const char *url;
+  struct request request;
+  time_t next;
+  size_t old_size;
+};
 
 const char *script = "", *CURR_VERSION = " version 0.6 ";
-char *url;
-bool done = false;
-
-char *retrieveURL(const char *url, int *total_bytes_recv, short port);
-
-void startServer(int fd);
+volatile bool done = false;
+struct ring *ring = NULL;
+size_t history = HISTORY << 20;
+const char *metrics_target = NULL, *trace_file = NULL;
+int marquee_ms = 0;
+struct metrics metrics;
+int metric_draw, metric_search, metric_headlines, metric_bytes,
+    metric_wakeups, metric_reindexed, metric_unindexed;
+
+void startServer(int fd, char **urls, int nurls);
+void sendHeadlines(int fd, char *recv_buff);
+int decodeEntities(char *text, int len);
+void sendText(int fd, const char *text, int size);
+void sendFlush(int fd);
 void startClient(int fd, pid_t server_pid);
+void drawText(WINDOW *text_win, struct store *store, struct view *view,
+              struct search *search);
+void drawResults(WINDOW *text_win, struct store *store, struct search *search);
+void drawLine(WINDOW *win, int row, struct layout *layout, int from, int to,
+              struct search *search);
+void runSearch(struct search *search, struct store *store,
+               struct index *index);
+void addHeadline(struct store *store, struct indexes *indexes,
+                 const char *text, int len);
+void stepIndex(struct store *store, struct indexes *indexes);
+void drawType(WINDOW *type_win, mmask_t mouse);
+void drawMetrics(WINDOW *text_win);
 
 void quitserver(int sig);
 void quitclient(int sig);
+void usage(const char *name);
 
 int main(int argc, char **argv, char **envp) {
 
-  if (argc < 2) {
+  int opt;
+  bool shared = false;
+
+  while ((opt = getopt(argc, argv, "e:M:m:sT:x:")) != -1) {
+    switch (opt) {
+    case 'e':
+      metrics_target = optarg;
+      break;
+    case 'M':
+      marquee_ms = atoi(optarg);
+      if (marquee_ms < 1) {
+        fprintf(stderr, "marquee steps must be at least 1 ms apart\n");
+        exit(1);
+      }
+      break;
+    case 'm':
+      if (atoi(optarg) < 1 || atoi(optarg) > HISTORYMAX) {
+        fprintf(stderr, "history must be within 1 and %d MiB\n", HISTORYMAX);
+        usage(argv[0]);
+      }
+      history = (size_t)atoi(optarg) << 20;
+      break;
+    case 's':
+      shared = true;
+      break;
+    case 'T':
+      trace_file = optarg;
+      break;
+    case 'x':
+      script = optarg;
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  if (optind >= argc) {
     fprintf(stderr, "missing url\n");
     exit(0);
   }
 
-  url = argv[1];
+  if (shared && (ring = ring_create(RINGSIZE)) == NULL)
+    fprintf(stderr, "shared memory transport unavailable, using pipe\n");
 
   int fd[2];
   pid_t child_pid;
@@ -77,98 +175,559 @@ int main(int argc, char **argv, char **envp) {
 
   if (child_pid == 0) { // parent....
     close(fd[WRITE]);
-    startClient(fd[READ], child_pid);
+    startClient(ring ? ring_fd(ring) : fd[READ], child_pid);
   } else {
     close(fd[READ]); // child......
     close(STDIN_FILENO);
-    startServer(fd[WRITE]);
+    startServer(fd[WRITE], argv + optind, argc - optind);
   }
 
   return (0);
 }
 
-void startServer(int fd) {
+void startServer(int fd, char **urls, int nurls) {
 
   signal(SIGQUIT, quitserver);
+  signal(SIGCHLD, quitserver); // the client is our child
+  signal(SIGPIPE, SIG_IGN);
+
+  // the server traces to a file of its own, next to the client's
+  char trace_path[BLOCKSIZE];
+  if (trace_file != NULL) {
+    snprintf(trace_path, BLOCKSIZE, "%s.server", trace_file);
+    if (trace_open(trace_path) == -1) {
+      int size =
+          snprintf(trace_path, BLOCKSIZE, "unable to trace to %s.server",
+                   trace_file);
+      sendText(fd, trace_path, size);
+    }
+  }
+
+  struct fetcher fetcher;
+  struct feed *feeds = (struct feed *)calloc(nurls, sizeof(struct feed));
+
+  if (feeds == NULL || fetch_init(&fetcher) == -1) {
+    const char *errstr = "ticker server was unable to start\n";
+    sendText(fd, errstr, strlen(errstr) - 1);
+    sendFlush(fd);
+    return;
+  }
 
-  int old_recv = 0, recv, send_buff_size = 0, size, nmesg;
+  for (int i = 0; i < nurls; i++) {
+    feeds[i].url = urls[i];
+    if (fetch_add(&fetcher, &feeds[i].request, urls[i]) == -1) {
+      char errstr[BLOCKSIZE];
+      int size = snprintf(errstr, BLOCKSIZE, "unsupported url %s", urls[i]);
+      sendText(fd, errstr, size);
+      feeds[i].url = NULL;
+    }
+  }
+  sendFlush(fd);
 
-  char *recv_buff = NULL, send_buff[BLOCKSIZE], *beg, *end, *listed[NMESG];
+  fd_set readfds, writefds;
 
   while (!done) {
-    recv_buff = retrieveURL(url, &recv, 80);
-    if (recv_buff == NULL) {
-      const char *errstr =
-          "connection to news server lost ...\nretrying in 60s\n";
-      write(fd, errstr, strlen(errstr) + 1);
-      sleep(60);
-      continue;
-    } else {
-      end = recv_buff;
-      if (old_recv < recv) {
-        for (int skip = 0; skip < 2; skip++) {
-          beg = strstr(end, "<title>");
-          if (!beg)
-            continue;
-          beg += 7;
-          end = strstr(beg, "</title>");
-        }
-        nmesg = 0;
-        for (int entry = 0; entry < NMESG; entry++) {
-          beg = strstr(end, "<title>");
-          if (!beg)
-            break;
-          ++nmesg;
-          beg += 7;
-          char *cdata = strstr(beg, "<![CDATA[");
-          if (cdata == beg) {
-            beg += 9;
-            end = strstr(beg, "]]>");
-          } else
-            end = strstr(beg, "</title>");
-          while (isspace((int)*beg))
-            ++beg;
-          while (end > beg && isspace((int)*end))
-            --end;
-          size = strlen(beg) - strlen(end);
-          *(listed + entry) = (char *)malloc(sizeof(char) * (size + 2));
-          strncpy(*(listed + entry), beg, size);
-          listed[entry][size] = '\n';
-          listed[entry][size + 1] = '\0';
-        }
-        for (int entry = nmesg - 1; entry > -1; entry--) {
-          size = strlen(*(listed + entry));
-          for (int i = 0; i < size; i++) {
-            send_buff[send_buff_size++] = *(*(listed + entry) + i);
-            if (send_buff_size >= (BLOCKSIZE - 1)) {
-              send_buff[BLOCKSIZE - 1] = '\0';
-              write(fd, send_buff, BLOCKSIZE);
-              send_buff_size = 0;
-            }
-          }
+    time_t now = time(NULL), timeout = INTERVAL;
+
+    for (int i = 0; i < nurls; i++) {
+      struct feed *feed = &feeds[i];
+      if (feed->url == NULL)
+        continue;
+      if (feed->request.state == FETCH_IDLE && feed->next <= now)
+        fetch_start(&fetcher, &feed->request);
+      if (feed->request.state == FETCH_DONE) {
+        if (feed->old_size < feed->request.body) {
+          sendHeadlines(fd, feed->request.buf);
+          feed->old_size = feed->request.body;
         }
-        if (send_buff_size > 0) {
-          memset(send_buff + send_buff_size, '\0', BLOCKSIZE - send_buff_size);
-          write(fd, send_buff, BLOCKSIZE);
-          send_buff_size = 0;
-        }
-        for (int entry = 0; entry < nmesg; entry++) {
-          free(*(listed + entry));
-          *(listed + entry) = NULL;
-        }
-        old_recv = recv;
+        feed->request.state = FETCH_IDLE;
+        feed->next = now + INTERVAL;
+      } else if (feed->request.state == FETCH_FAILED) {
+        char errstr[BLOCKSIZE];
+        int size = snprintf(errstr, BLOCKSIZE,
+                            "connection to %s lost ...\nretrying in %ds",
+                            feed->request.host, RETRY);
+        sendText(fd, errstr, size);
+        sendFlush(fd);
+        feed->request.state = FETCH_IDLE;
+        feed->next = now + RETRY;
       }
-      free(recv_buff);
-      recv_buff = NULL;
+      if (feed->request.state == FETCH_IDLE && feed->next - now < timeout)
+        timeout = feed->next - now;
     }
-    sleep(INTERVAL);
+
+    FD_ZERO(&readfds);
+    FD_ZERO(&writefds);
+    int maxfd = fetch_fds(&fetcher, &readfds, &writefds, -1, &timeout);
+
+    struct timeval tv = {timeout, 0};
+    if (select(maxfd + 1, &readfds, &writefds, NULL, &tv) == -1) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+
+    fetch_process(&fetcher, &readfds, &writefds);
+
+    allocguard_frame();
   }
+
+  fetch_free(&fetcher);
+  free(feeds);
+
+  trace_close();
+
   printf("ticker server exited normally\n");
 }
 
+void sendHeadlines(int fd, char *recv_buff) {
+
+  TRACE("parse");
+
+  int nmesg = 0, listed_size[NMESG];
+
+  char *beg, *end = recv_buff, *listed[NMESG];
+
+  for (int skip = 0; skip < 2; skip++) {
+    beg = strstr(end, "<title>");
+    if (!beg)
+      continue;
+    beg += 7;
+    end = strstr(beg, "</title>");
+    if (!end)
+      return;
+  }
+  for (int entry = 0; entry < NMESG; entry++) {
+    beg = strstr(end, "<title>");
+    if (!beg)
+      break;
+    beg += 7;
+    char *cdata = strstr(beg, "<![CDATA[");
+    if (cdata == beg) {
+      beg += 9;
+      end = strstr(beg, "]]>");
+    } else
+      end = strstr(beg, "</title>");
+    if (!end)
+      break;
+    ++nmesg;
+    while (isspace((int)*beg))
+      ++beg;
+    while (end > beg && isspace((int)*end))
+      --end;
+    // headlines stay in recv_buff until sent
+    listed[entry] = beg;
+    listed_size[entry] = decodeEntities(beg, end - beg);
+  }
+
+  for (int entry = nmesg - 1; entry > -1; entry--)
+    sendText(fd, listed[entry], listed_size[entry]);
+  sendFlush(fd);
+}
+
+struct entity {
+  const char *name, *utf8;
+} entities[] = {{"amp", "&"},
+                {"lt", "<"},
+                {"gt", ">"},
+                {"quot", "\""},
+                {"apos", "'"},
+                {"nbsp", "\u00a0"},
+                {"ndash", "\u2013"},
+                {"mdash", "\u2014"},
+                {"lsquo", "\u2018"},
+                {"rsquo", "\u2019"},
+                {"ldquo", "\u201c"},
+                {"rdquo", "\u201d"},
+                {"hellip", "\u2026"}};
+
+// decoded entities are never longer than their source, so work in place
+int decodeEntities(char *text, int len) {
+
+  int in = 0, out = 0;
+
+  while (in < len) {
+    char *semi = NULL;
+    if (text[in] == '&')
+      semi = memchr(text + in, ';', len - in < 12 ? len - in : 12);
+    if (semi == NULL) {
+      // control characters would break the line framing
+      text[out++] = (unsigned char)text[in] < ' ' ? ' ' : text[in];
+      ++in;
+      continue;
+    }
+
+    char *name = text + in + 1, utf8[4];
+    int name_len = semi - name, size = 0;
+    if (name_len > 1 && name[0] == '#') {
+      bool hex = name[1] == 'x' || name[1] == 'X';
+      char *digits = name + 1 + hex, *last;
+      long code = 0;
+      if (digits < semi && (hex ? isxdigit(*digits) : isdigit(*digits)))
+        code = strtol(digits, &last, hex ? 16 : 10);
+      if (code > 0 && last == semi && code <= 0x10ffff &&
+          (code < 0xd800 || code > 0xdfff)) {
+        if (code < ' ')
+          code = ' ';
+        if (code < 0x80)
+          utf8[size++] = code;
+        else if (code < 0x800) {
+          utf8[size++] = 0xc0 | (code >> 6);
+          utf8[size++] = 0x80 | (code & 0x3f);
+        } else if (code < 0x10000) {
+          utf8[size++] = 0xe0 | (code >> 12);
+          utf8[size++] = 0x80 | ((code >> 6) & 0x3f);
+          utf8[size++] = 0x80 | (code & 0x3f);
+        } else {
+          utf8[size++] = 0xf0 | (code >> 18);
+          utf8[size++] = 0x80 | ((code >> 12) & 0x3f);
+          utf8[size++] = 0x80 | ((code >> 6) & 0x3f);
+          utf8[size++] = 0x80 | (code & 0x3f);
+        }
+      }
+    } else
+      for (size_t i = 0; i < sizeof(entities) / sizeof(struct entity); i++)
+        if (strlen(entities[i].name) == (size_t)name_len &&
+            memcmp(entities[i].name, name, name_len) == 0) {
+          size = strlen(entities[i].utf8);
+          memcpy(utf8, entities[i].utf8, size);
+          break;
+        }
+
+    if (size == 0) {
+      text[out++] = text[in++];
+      continue;
+    }
+    memcpy(text + out, utf8, size);
+    out += size;
+    in = semi - text + 1;
+  }
+
+  return (out);
+}
+
+char send_buff[BLOCKSIZE];
+int send_buff_size = 0;
+
+void sendText(int fd, const char *text, int size) {
+
+  if (ring) {
+    char *record = ring_reserve(ring, size + 1);
+    if (record == NULL)
+      return;
+    memcpy(record, text, size);
+    record[size] = '\n';
+    ring_commit(ring, size + 1);
+    return;
+  }
+
+  // the pipe carries NUL padded blocks of BLOCKSIZE
+  for (int i = 0; i <= size; i++) {
+    send_buff[send_buff_size++] = i < size ? text[i] : '\n';
+    if (send_buff_size >= (BLOCKSIZE - 1)) {
+      send_buff[BLOCKSIZE - 1] = '\0';
+      write(fd, send_buff, BLOCKSIZE);
+      send_buff_size = 0;
+    }
+  }
+}
+
+void sendFlush(int fd) {
+
+  if (ring) {
+    ring_notify(ring);
+    return;
+  }
+
+  if (send_buff_size > 0) {
+    memset(send_buff + send_buff_size, '\0', BLOCKSIZE - send_buff_size);
+    write(fd, send_buff, BLOCKSIZE);
+    send_buff_size = 0;
+  }
+}
+
+void addHeadline(struct store *store, struct indexes *indexes,
+                 const char *text, int len) {
+
+  struct index *live = &indexes->index[indexes->live];
+  unsigned long seq = store_add(store, text, len);
+
+  text = store_get(store, seq, &len);
+  if (index_add(live, seq, text, len, store->first) == -1)
+    metrics_add(&metrics, metric_unindexed, 1);
+
+  // once half the store turned over since the last rebuild, or a quarter
+  // when the arenas run full, so the index stays in proportion to the store
+  unsigned long evicted = store->first - indexes->rebuilt,
+                kept = store->next - store->first;
+
+  if (!indexes->rebuilding && evicted > 0 &&
+      (evicted >= kept / 2 || (index_full(live) && evicted >= kept / 4))) {
+    indexes->next = indexes->rebuilt = store->first;
+    indexes->rebuilding = true;
+  }
+
+  ++indexes->arrived;
+
+  metrics_add(&metrics, metric_headlines, 1);
+}
+
+void stepIndex(struct store *store, struct indexes *indexes) {
+
+  TRACE("reindex");
+
+  struct index *spare = &indexes->index[!indexes->live];
+  int len, step = INDEXSTEP + 2 * indexes->arrived;
+
+  indexes->arrived = 0;
+
+  if (indexes->next < store->first)
+    indexes->next = store->first;
+
+  for (int i = 0; i < step && indexes->next < store->next; i++) {
+    const char *text = store_get(store, indexes->next, &len);
+    index_add(spare, indexes->next++, text, len, store->first);
+  }
+
+  if (indexes->next < store->next)
+    return;
+
+  indexes->live = !indexes->live;
+  indexes->rebuilding = false;
+  index_reset(&indexes->index[!indexes->live]);
+  metrics_add(&metrics, metric_reindexed, 1);
+}
+
+void runSearch(struct search *search, struct store *store,
+               struct index *index) {
+
+  TRACE("search");
+
+  int pos = 0, start, tok_len;
+
+  search->ntokens = 0;
+  while (search->ntokens < INDEXMAXQUERY &&
+         (start = index_token(search->query, search->len, &pos, &tok_len)) !=
+             -1) {
+    search->tokens[search->ntokens][0] = start;
+    search->tokens[search->ntokens++][1] = tok_len;
+  }
+
+  uint64_t began = metrics_now();
+
+  int n = index_query(index, search->query, search->len, store->first,
+                      search->results, NRESULTS);
+
+  // some headlines did not make it into the index
+  search->partial = index->dropped > 0;
+
+  // feeds are refetched whole, show each distinct headline once
+  search->nresults = 0;
+  for (int i = 0; i < n; i++) {
+    int len, other_len, j;
+    const char *text = store_get(store, search->results[i], &len);
+    for (j = 0; j < search->nresults; j++) {
+      const char *other = store_get(store, search->results[j], &other_len);
+      if (other_len == len && memcmp(other, text, len) == 0)
+        break;
+    }
+    if (j == search->nresults)
+      search->results[search->nresults++] = search->results[i];
+  }
+
+  search->top = 0;
+
+  metrics_observe(&metrics, metric_search, metrics_now() - began);
+}
+
+void drawLine(WINDOW *win, int row, struct layout *layout, int from, int to,
+              struct search *search) {
+
+  const char *text = layout->text;
+  int pos = layout->off[from], len = layout->off[to], done = from, start,
+      tok_len;
+
+  wmove(win, row, 2);
+  if (search != NULL)
+    while ((start = index_token(text, len, &pos, &tok_len)) != -1) {
+      int i = 0;
+      for (; i < search->ntokens; i++)
+        if (index_same(text + start, tok_len,
+                       search->query + search->tokens[i][0],
+                       search->tokens[i][1]))
+          break;
+      if (i == search->ntokens)
+        continue;
+      // tokens are found on the text, map them back to characters
+      int first = done, last;
+      while (layout->off[first] < start)
+        ++first;
+      for (last = first; layout->off[last] < start + tok_len; last++)
+        ;
+      waddnwstr(win, layout->wide + done, first - done);
+      wattron(win, A_REVERSE);
+      waddnwstr(win, layout->wide + first, last - first);
+      wattroff(win, A_REVERSE);
+      done = last;
+    }
+  waddnwstr(win, layout->wide + done, to - done);
+}
+
+void drawResults(WINDOW *text_win, struct store *store,
+                 struct search *search) {
+
+  int row_text_win, col_text_win, breaks[STOREMAXWRAP];
+  struct layout layout;
+
+  getmaxyx(text_win, row_text_win, col_text_win);
+
+  int width = col_text_win - 4, height = row_text_win - 2, row = 1;
+
+  werase(text_win);
+
+  // newest match on top
+  search->shown = 0;
+  for (int i = search->top; i < search->nresults && row <= height; i++) {
+    int len;
+    const char *text = store_get(store, search->results[i], &len);
+    if (text == NULL)
+      continue;
+    int n = store_layout(text, len, &layout),
+        nlines = store_wrap(&layout, width, breaks, STOREMAXWRAP);
+    if (nlines > STOREMAXWRAP)
+      nlines = STOREMAXWRAP;
+    for (int line = 0; line < nlines && row <= height; line++, row++) {
+      int end = line + 1 < nlines ? breaks[line + 1] : n;
+      while (end > breaks[line] && layout.wide[end - 1] == L' ')
+        --end;
+      drawLine(text_win, row, &layout, breaks[line], end, search);
+    }
+    ++search->shown;
+  }
+
+  box(text_win, 0, 0);
+  wattron(text_win, A_BOLD);
+  mvwprintw(text_win, 0, 2, " search: %.*s ", col_text_win - 16, search->query);
+  wattroff(text_win, A_BOLD);
+  mvwprintw(text_win, row_text_win - 1, 2,
+            " %d found%s, Enter on empty line to return ", search->nresults,
+            search->partial ? " (index full)" : "");
+  if (metrics.hud)
+    drawMetrics(text_win);
+  wrefresh(text_win);
+}
+
+void drawText(WINDOW *text_win, struct store *store, struct view *view,
+              struct search *search) {
+
+  TRACE("render");
+
+  uint64_t start = metrics_now();
+
+  if (search->active) {
+    drawResults(text_win, store, search);
+    metrics_observe(&metrics, metric_draw, metrics_now() - start);
+    return;
+  }
+
+  int row_text_win, col_text_win, breaks[STOREMAXWRAP];
+  struct layout layout;
+
+  getmaxyx(text_win, row_text_win, col_text_win);
+
+  int width = col_text_win - 4, height = row_text_win - 2;
+
+  if (view->follow)
+    view_follow(store, view, width);
+  else
+    view_scroll(store, view, width, 0, height);
+
+  werase(text_win);
+
+  // walk up from the bottom line of the viewport, only visible lines are drawn
+  unsigned long seq = view->seq;
+  int row = height, line = view->line;
+  while (row > 0 && seq >= store->first && seq < store->next) {
+    int len;
+    const char *text = store_get(store, seq, &len);
+    int n = store_layout(text, len, &layout),
+        nlines = store_wrap(&layout, width, breaks, STOREMAXWRAP);
+    if (nlines > STOREMAXWRAP)
+      nlines = STOREMAXWRAP;
+    if (line >= nlines)
+      line = nlines - 1;
+    if (seq & 1)
+      wattron(text_win, A_BOLD);
+    for (; line >= 0 && row > 0; line--, row--) {
+      int end = line + 1 < nlines ? breaks[line + 1] : n;
+      while (end > breaks[line] && layout.wide[end - 1] == L' ')
+        --end;
+      drawLine(text_win, row, &layout, breaks[line], end, NULL);
+    }
+    wattroff(text_win, A_BOLD);
+    if (seq == store->first)
+      break;
+    --seq;
+    line = store_lines(store, seq, width) - 1;
+  }
+
+  box(text_win, 0, 0);
+  wattron(text_win, A_BOLD);
+  mvwprintw(text_win, 0, (col_text_win - strlen(" ticker ")) / 2, " ticker ");
+  wattroff(text_win, A_BOLD);
+  if (!view->follow)
+    mvwprintw(text_win, row_text_win - 1,
+              col_text_win - strlen(" PgDn for more ") - 2, " PgDn for more ");
+  if (metrics.hud)
+    drawMetrics(text_win);
+  wrefresh(text_win);
+
+  metrics_observe(&metrics, metric_draw, metrics_now() - start);
+}
+
+// the HUD covers the top rows of the text window
+void drawMetrics(WINDOW *text_win) {
+
+  int row_text_win, col_text_win;
+  char line[METRICSLINE];
+
+  getmaxyx(text_win, row_text_win, col_text_win);
+
+  int width = col_text_win - 4;
+
+  for (int i = 0; i < row_text_win - 2 &&
+                  metrics_hud(&metrics, i, line, METRICSLINE);
+       i++)
+    mvwprintw(text_win, i + 1, 2, "%-*.*s", width, width, line);
+}
+
+void drawType(WINDOW *type_win, mmask_t mouse) {
+
+  int row_type_win, col_type_win;
+
+  getmaxyx(type_win, row_type_win, col_type_win);
+
+  box(type_win, 0, 0);
+  if (!mouse)
+    mvwprintw(type_win, 0, col_type_win - 13, " mouse off ");
+  else
+    mvwprintw(type_win, 0, col_type_win - 12, " mouse on ");
+  wattron(type_win, A_BOLD);
+  mvwprintw(type_win, row_type_win - 1, 2, " Press F1 or CTRL-C to exit ");
+  wattroff(type_win, A_BOLD);
+  mvwprintw(type_win, row_type_win - 1, col_type_win - strlen(CURR_VERSION) - 2,
+            CURR_VERSION);
+}
+
 void startClient(int fd, pid_t server_pid) {
 
   signal(SIGQUIT, quitclient);
+  signal(SIGPIPE, SIG_IGN);
+
+  // forked while the client is still small
+  struct worker *worker = NULL;
+  if (*script && (worker = worker_start(script)) == NULL)
+    fprintf(stderr, "ticker was unable to start %s\n", script);
 
   char *locale = setlocale(LC_ALL, "");
   if (locale == NULL)
@@ -176,6 +735,47 @@ void startClient(int fd, pid_t server_pid) {
   else
     printf("ticker set locale to %s\n", locale);
 
+  struct store store;
+  struct view view = {0, 0, true};
+  struct indexes indexes;
+  struct search search;
+  struct marquee marquee;
+
+  search.active = search.partial = false;
+  indexes.live = 0;
+  indexes.rebuilding = false;
+  indexes.rebuilt = 0;
+  indexes.arrived = 0;
+
+  if (store_init(&store, history) == -1 ||
+      index_init(&indexes.index[0], history) == -1 ||
+      index_init(&indexes.index[1], history) == -1 ||
+      (marquee_ms > 0 && marquee_init(&marquee) == -1)) {
+    fprintf(stderr, "ticker was unable to allocate history\n");
+    worker_stop(worker);
+    kill(server_pid, SIGQUIT);
+    return;
+  }
+
+  if (metrics_init(&metrics, "ticker", metrics_target) == -1) {
+    fprintf(stderr, "ticker was unable to export metrics to %s\n",
+            metrics_target);
+    worker_stop(worker);
+    kill(server_pid, SIGQUIT);
+    return;
+  }
+
+  if (trace_file != NULL && trace_open(trace_file) == -1)
+    fprintf(stderr, "ticker was unable to trace to %s\n", trace_file);
+
+  metric_draw = metrics_histogram(&metrics, "draw_ns", true);
+  metric_search = metrics_histogram(&metrics, "search_ns", true);
+  metric_headlines = metrics_counter(&metrics, "headlines");
+  metric_bytes = metrics_counter(&metrics, "bytes");
+  metric_wakeups = metrics_counter(&metrics, "wakeups");
+  metric_reindexed = metrics_counter(&metrics, "reindexed");
+  metric_unindexed = metrics_counter(&metrics, "unindexed");
+
   initscr();
   raw();
   noecho();
@@ -189,13 +789,20 @@ void startClient(int fd, pid_t server_pid) {
   int row_stdscr, col_stdscr, row_text_win, col_text_win, row_type_win,
       col_type_win;
 
-  WINDOW *text_win, *type_win;
+  WINDOW *text_win, *type_win, *marquee_win = NULL;
+
+  // the marquee takes the bottom row
+  int strip = marquee_ms > 0;
 
   getmaxyx(stdscr, row_stdscr, col_stdscr);
-  text_win = newwin(row_stdscr - FIELD, col_stdscr, 0, 0);
-  type_win = newwin(FIELD, col_stdscr, row_stdscr - FIELD, 0);
+  text_win = newwin(row_stdscr - FIELD - strip, col_stdscr, 0, 0);
+  type_win = newwin(FIELD, col_stdscr, row_stdscr - FIELD - strip, 0);
+  if (strip) {
+    marquee_win = newwin(1, col_stdscr, row_stdscr - 1, 0);
+    leaveok(marquee_win, true);
+    marquee_build(&marquee, &store, col_stdscr);
+  }
 
-  scrollok(text_win, true);
   clearok(text_win, true);
   clearok(type_win, true);
 
@@ -204,119 +811,160 @@ void startClient(int fd, pid_t server_pid) {
 
   leaveok(text_win, true);
 
-  box(text_win, 0, 0);
-
   getmaxyx(text_win, row_text_win, col_text_win);
   getmaxyx(type_win, row_type_win, col_type_win);
 
-  wattron(text_win, A_BOLD);
-  mvwprintw(text_win, 0, (col_text_win - strlen(" ticker ")) / 2, " ticker ");
-  wattroff(text_win, A_BOLD);
-
   keypad(type_win, true);
-
-  box(type_win, 0, 0);
-  wattron(type_win, A_BOLD);
-  mvwprintw(type_win, row_type_win - 1, 2, " Press F1 or CTRL-C to exit ");
-  wattroff(type_win, A_BOLD);
-  mvwprintw(type_win, row_type_win - 1, col_type_win - strlen(CURR_VERSION) - 2,
-            CURR_VERSION);
-  wmove(type_win, 0, 0);
+  nodelay(type_win, true);
 
   mmask_t mouse = mousemask(ALL_MOUSE_EVENTS, NULL);
 
-  if (!mouse)
-    mvwprintw(type_win, 0, col_type_win - 13, " mouse off ");
-  else
-    mvwprintw(type_win, 0, col_type_win - 12, " mouse on ");
+  drawType(type_win, mouse);
+  wmove(type_win, 0, 0);
 
   wrefresh(type_win);
-  wrefresh(text_win);
+  drawText(text_win, &store, &view, &search);
 
   fd_set readfds, testfds;
   FD_ZERO(&readfds);
   FD_SET(STDIN_FILENO, &readfds);
   FD_SET(fd, &readfds);
+  int maxfd = fd;
+  if (worker != NULL) {
+    FD_SET(worker_fd(worker), &readfds);
+    if (worker_fd(worker) > maxfd)
+      maxfd = worker_fd(worker);
+  }
   testfds = readfds;
 
-  int c, pos = 2, line = row_text_win - 2, column = 2, chr = 0, typed = 0,
-         backed = 0, inputline = 1;
+  int c, pos = 2, chr = 0, backed = 0, inputline = 1, pending = 0;
 
-  char message[MESGSIZE], msg[BLOCKSIZE], *next_space = NULL,
-                                          *next_newline = NULL;
-  bool highlight = false;
+  char message[MESGSIZE], msg[BLOCKSIZE], partial[STOREMAXLEN];
+  const char *chunk, *newline;
 
   MEVENT mevent;
-  while (!done && select(fd + 1, &testfds, NULL, NULL, NULL) > 0) {
+  uint64_t marquee_due = metrics_now();
+
+  // localtime allocates, so the year is looked up before the frame loop
+  time_t t = time(NULL);
+  int year = 1900 + localtime(&t)->tm_year;
+  while (!done) {
+    // wake up to roll the metrics window when anyone is looking at it, and
+    // for the next step of the marquee
+    struct timeval tv, *timeout = NULL;
+    uint64_t now = metrics_now(), due = UINT64_MAX;
+    if (metrics.hud || metrics_target != NULL)
+      due = metrics.roll;
+    if (marquee_win != NULL && marquee_due < due)
+      due = marquee_due;
+    // a rebuild of the index goes on in between
+    if (indexes.rebuilding)
+      due = now;
+    if (due != UINT64_MAX) {
+      uint64_t wait = due > now ? due - now : 0;
+      tv.tv_sec = wait / 1000000000;
+      tv.tv_usec = wait % 1000000000 / 1000;
+      timeout = &tv;
+    }
+    if (select(maxfd + 1, &testfds, NULL, NULL, timeout) == -1) {
+      if (errno != EINTR)
+        break;
+      // SIGWINCH: let wgetch pick up KEY_RESIZE
+      FD_ZERO(&testfds);
+      FD_SET(STDIN_FILENO, &testfds);
+    }
+    metrics_add(&metrics, metric_wakeups, 1);
+    if (indexes.rebuilding)
+      stepIndex(&store, &indexes);
+    if (metrics_tick(&metrics, metrics_now()) && metrics.hud) {
+      drawText(text_win, &store, &view, &search);
+      wrefresh(type_win);
+    }
+    // steps missed while busy are skipped, the cursor stays in type_win
+    if (marquee_win != NULL && (now = metrics_now()) >= marquee_due) {
+      TRACE("marquee");
+      marquee_step(&marquee);
+      marquee_draw(&marquee, marquee_win);
+      wnoutrefresh(marquee_win);
+      wnoutrefresh(type_win);
+      doupdate();
+      marquee_due += marquee_ms * 1000000ull;
+      if (marquee_due <= now)
+        marquee_due = now + marquee_ms * 1000000ull;
+    }
+    // what the script prints joins the headlines
+    if (worker != NULL && FD_ISSET(worker_fd(worker), &testfds)) {
+      const char *line;
+      int len;
+      if (worker_read(worker) == 0)
+        FD_CLR(worker_fd(worker), &readfds);
+      while ((line = worker_line(worker, &len)) != NULL)
+        if (len > 0)
+          addHeadline(&store, &indexes, line, len);
+      if (search.active)
+        runSearch(&search, &store, &indexes.index[indexes.live]);
+      if (marquee_win != NULL)
+        marquee_build(&marquee, &store, col_stdscr);
+      drawText(text_win, &store, &view, &search);
+      wrefresh(type_win);
+    }
     if (FD_ISSET(fd, &testfds)) {
+      TRACE("receive");
       curs_set(0);
-      int read_bytes = read(fd, msg, BLOCKSIZE);
-      for (int i = 0; i < read_bytes; i++) {
-        if (line < (row_text_win - 4)) {
-          wmove(text_win, row_text_win - 1, 0);
-          wclrtoeol(text_win);
-          wscrl(text_win, 1);
-          wmove(text_win, 2, 0);
-          wclrtoeol(text_win);
-          line = row_text_win - 4;
+      int read_bytes;
+      if (ring)
+        ring_clear(ring);
+      do {
+        // ring records are read in place, the pipe goes through msg
+        if (ring) {
+          if ((chunk = ring_peek(ring, &read_bytes)) == NULL)
+            break;
+        } else {
+          chunk = msg;
+          read_bytes = read(fd, msg, BLOCKSIZE);
+          if (read_bytes > 0)
+            read_bytes = strnlen(msg, read_bytes);
         }
-        if (!msg[i])
-          break;
-        switch (msg[i]) {
-        case '\n':
-          typed = 0;
-          if (highlight)
-            wattroff(text_win, A_BOLD);
-          else
-            wattron(text_win, A_BOLD);
-          highlight = !highlight;
-          wmove(text_win, row_text_win - 1, 0);
-          wclrtoeol(text_win);
-          wscrl(text_win, 1);
-          wmove(text_win, 1, 0);
-          wclrtoeol(text_win);
-          line = row_text_win - 2;
-          column = 2;
-          break;
-        case ' ':
-          if ((next_space = index(msg + i + 1, ' ')) == NULL)
-            next_space = msg + BLOCKSIZE;
-          if ((next_newline = index(msg + i + 1, '\n')) == NULL)
-            next_newline = msg + BLOCKSIZE;
-          if (next_newline < next_space)
-            next_space = next_newline;
-          if (((next_space - msg - i) > (col_text_win - column - 2))) {
-            wmove(text_win, row_text_win - 1, 0);
-            wclrtoeol(text_win);
-            wscrl(text_win, 1);
-            line = row_text_win - 2;
-            column = 2;
+        if (read_bytes > 0)
+          metrics_add(&metrics, metric_bytes, read_bytes);
+        // headlines may straddle pipe blocks, partial holds the head of one
+        while (read_bytes > 0) {
+          int size = read_bytes;
+          if ((newline = memchr(chunk, '\n', read_bytes)) != NULL)
+            size = newline - chunk;
+          if (size > STOREMAXLEN - pending)
+            size = STOREMAXLEN - pending;
+          if (newline == NULL || pending > 0) {
+            memcpy(partial + pending, chunk, size);
+            pending += size;
           }
-        default:
-          if (msg[i] == '(' && typed < 9)
-            for (; typed < 9; typed++)
-              mvwaddch(text_win, line, ++column, ' ');
-          mvwaddch(text_win, line, column++, msg[i]);
-          typed++;
-          break;
-        };
-      }
-      wattroff(text_win, A_BOLD);
-      box(text_win, 0, 0);
-      wattron(text_win, A_BOLD);
-      mvwprintw(text_win, 0, (col_text_win - strlen(" ticker ")) / 2,
-                " ticker ");
-      wattroff(text_win, A_BOLD);
-      wrefresh(text_win);
-      if (highlight)
-        wattron(text_win, A_BOLD);
-      if (!highlight)
-        wattroff(text_win, A_BOLD);
+          if (newline != NULL) {
+            if (pending > 0)
+              addHeadline(&store, &indexes, partial, pending);
+            else if (size > 0)
+              addHeadline(&store, &indexes, chunk, size);
+            pending = 0;
+            size = newline - chunk + 1;
+          } else
+            size = read_bytes;
+          chunk += size;
+          read_bytes -= size;
+        }
+        if (ring)
+          ring_pop(ring);
+      } while (ring);
+      if (search.active)
+        runSearch(&search, &store, &indexes.index[indexes.live]);
+      if (marquee_win != NULL)
+        marquee_build(&marquee, &store, col_stdscr);
+      drawText(text_win, &store, &view, &search);
     } else if (FD_ISSET(STDIN_FILENO, &testfds)) {
       curs_set(1);
       c = wgetch(type_win);
       if (c == KEY_F(1) || c == 3)
         break;
+      else if (c == ERR)
+        ;
       else if (c == KEY_MOUSE) {
         curs_set(0);
         if (getmouse(&mevent) == OK) {
@@ -326,34 +974,79 @@ void startClient(int fd, pid_t server_pid) {
         }
       } else {
         switch (c) {
+        case KEY_PPAGE:
+        case KEY_NPAGE:
+          if (search.active) {
+            if (c == KEY_NPAGE) {
+              if (search.top + search.shown < search.nresults)
+                search.top += search.shown;
+            } else
+              search.top -= search.shown > 0 ? search.shown : 1;
+            if (search.top < 0)
+              search.top = 0;
+          } else
+            view_scroll(&store, &view, col_text_win - 4,
+                        (c == KEY_PPAGE ? -1 : 1) * (row_text_win - 3),
+                        row_text_win - 2);
+          drawText(text_win, &store, &view, &search);
+          wmove(type_win, inputline, pos);
+          break;
+        case KEY_F(2):
+          metrics.hud = !metrics.hud;
+          drawText(text_win, &store, &view, &search);
+          wmove(type_win, inputline, pos);
+          break;
+        case KEY_END:
+          search.active = false;
+          view_follow(&store, &view, col_text_win - 4);
+          drawText(text_win, &store, &view, &search);
+          wmove(type_win, inputline, pos);
+          break;
+        case KEY_RESIZE:
+          getmaxyx(stdscr, row_stdscr, col_stdscr);
+          wresize(text_win, row_stdscr - FIELD - strip, col_stdscr);
+          wresize(type_win, FIELD, col_stdscr);
+          mvwin(type_win, row_stdscr - FIELD - strip, 0);
+          if (marquee_win != NULL) {
+            wresize(marquee_win, 1, col_stdscr);
+            mvwin(marquee_win, row_stdscr - 1, 0);
+            marquee_build(&marquee, &store, col_stdscr);
+          }
+          getmaxyx(text_win, row_text_win, col_text_win);
+          getmaxyx(type_win, row_type_win, col_type_win);
+          werase(type_win);
+          drawType(type_win, mouse);
+          pos = 2;
+          inputline = 1;
+          for (int i = 0; i < chr; i++) {
+            if (pos > col_type_win - 3 && inputline < row_type_win - 2) {
+              inputline++;
+              pos = 2;
+            }
+            mvwaddch(type_win, inputline, pos++, message[i]);
+          }
+          backed = 0;
+          wmove(type_win, inputline, pos);
+          // wrap points are recomputed lazily for the new width
+          drawText(text_win, &store, &view, &search);
+          break;
         case '\n':
           pos = 2;
-          column = 2;
           inputline = 1;
           message[chr] = '\0';
-          chr = 0;
-          line = row_text_win - 4;
-          int childpid;
-          if ((childpid = fork()) > 0) {
-            close(fd);
-            close(STDIN_FILENO);
-            execl(script, script, message, NULL);
-            exit(0);
-          }
+          // the typed line is a query, an empty line returns to the feed
+          memcpy(search.query, message, chr + 1);
+          search.len = chr;
+          if ((search.active = chr > 0))
+            runSearch(&search, &store, &indexes.index[indexes.live]);
           werase(type_win);
-          box(type_win, 0, 0);
-          if (!mouse)
-            mvwprintw(type_win, 0, col_type_win - 13, " mouse off ");
-          else
-            mvwprintw(type_win, 0, col_type_win - 12, " mouse on ");
-          wattron(type_win, A_BOLD);
-          mvwprintw(type_win, row_type_win - 1, 2,
-                    " Press F1 or CTRL-C to exit ");
-          wattroff(type_win, A_BOLD);
-          mvwprintw(type_win, row_type_win - 1,
-                    col_type_win - strlen(CURR_VERSION) - 2, CURR_VERSION);
+          drawType(type_win, mouse);
+          // handed to the worker, which runs the script in the background
+          if (worker != NULL && worker_send(worker, message, chr) == -1)
+            mvwprintw(type_win, 0, 2, " script not started ");
+          chr = 0;
           wmove(type_win, inputline, pos);
-          wrefresh(text_win);
+          drawText(text_win, &store, &view, &search);
           break;
         case KEY_LEFT:
           if (inputline > 1 && pos == 2) {
@@ -386,13 +1079,7 @@ void startClient(int fd, pid_t server_pid) {
             --pos;
             wmove(type_win, inputline, pos);
             wclrtoeol(type_win);
-            box(type_win, 0, 0);
-            wattron(type_win, A_BOLD);
-            mvwprintw(type_win, row_type_win - 1, 2,
-                      " Press F1 or CTRL-C to exit ");
-            wattroff(type_win, A_BOLD);
-            mvwprintw(type_win, row_type_win - 1,
-                      col_type_win - strlen(CURR_VERSION) - 2, CURR_VERSION);
+            drawType(type_win, mouse);
             wmove(type_win, inputline, pos);
           }
           break;
@@ -404,7 +1091,8 @@ void startClient(int fd, pid_t server_pid) {
             pos = 2;
           }
 
-          if ((chr < MESGSIZE) && (c > 31) && (pos < col_type_win - 2)) {
+          // room is left for the terminating nul
+          if ((chr < MESGSIZE - 1) && (c > 31) && (pos < col_type_win - 2)) {
             mvwaddch(type_win, inputline, pos++, c);
             message[chr++] = (char)c;
           }
@@ -413,17 +1101,28 @@ void startClient(int fd, pid_t server_pid) {
       wrefresh(type_win);
     }
     testfds = readfds;
+
+    allocguard_frame();
   }
 
   delwin(text_win);
   delwin(type_win);
+  if (marquee_win != NULL) {
+    delwin(marquee_win);
+    marquee_free(&marquee);
+  }
   endwin();
 
-  time_t t = time(NULL);
-  struct tm *tm_s = localtime(&t);
+  worker_stop(worker);
+
+  index_free(&indexes.index[0]);
+  index_free(&indexes.index[1]);
+  store_free(&store);
+  metrics_free(&metrics);
 
-  printf("ticker client exited normally\nKrizTioaN 2004/%d\n",
-         1900 + tm_s->tm_year);
+  trace_close();
+
+  printf("ticker client exited normally\nKrizTioaN 2004/%d\n", year);
 
   kill(server_pid, SIGQUIT);
 }
@@ -432,117 +1131,11 @@ void quitserver(int sig) { done = true; }
 
 void quitclient(int sig) { done = true; }
 
-#define BUFF_LEN 1024 // block size
-
-char *retrieveURL(const char *url, int *total_bytes_recv, short port) {
-
-  *total_bytes_recv = 0;
-
-  if (!url || !*url)
-    return NULL;
-
-  struct protoent *protocol = getprotobyname("tcp");
-  if (protocol == NULL)
-    return (NULL);
-
-  int sockfd = socket(AF_INET, SOCK_STREAM, protocol->p_proto);
-  if (sockfd == -1)
-    return (NULL);
-
-  int yes = 1;
-  if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int)) == -1)
-    return (NULL);
-
-  struct sockaddr_in local, remote;
-
-  local.sin_family = AF_INET;
-  local.sin_port = htons(0);
-  local.sin_addr.s_addr = htonl(INADDR_ANY);
-  memset(&local.sin_zero, '\0', 8);
-  if (bind(sockfd, (struct sockaddr *)&local, sizeof(struct sockaddr)) == -1)
-    return (NULL);
-
-  remote.sin_family = AF_INET;
-  remote.sin_port = htons(port);
-
-  size_t urllen = strlen(url);
-  char *file = strchr(url, '/');
-  size_t filelen = file ? strlen(file) : 0;
-  char *host = (char *)malloc(urllen - filelen + 1);
-  if (host == NULL)
-    return (NULL);
-
-  host[urllen - filelen] = '\0';
-  strncpy(host, url, urllen - filelen);
-  struct hostent *remote_host = gethostbyname(host);
-  if (remote_host == NULL) {
-    herror("gethostbyname");
-    free(host);
-    return (NULL);
-  }
-  remote.sin_addr = *((struct in_addr *)remote_host->h_addr);
-  memset(&remote.sin_zero, '\0', 8);
-
-  if (connect(sockfd, (struct sockaddr *)&remote, sizeof(struct sockaddr)) ==
-      -1) {
-    free(host);
-    return (NULL);
-  }
-
-  char *methodstr = "GET ", *versionstr = " HTTP/1.0\n",
-       *hoststr = "Host: ", *termstr = "\n\n",
-       *msg = (char *)malloc(
-           sizeof(char) * (strlen(methodstr) + filelen + strlen(versionstr)) +
-           strlen(hoststr) + strlen(host) + strlen(termstr) + 1);
-  if (msg == NULL) {
-    free(host);
-    return (NULL);
-    }
-  strcpy(msg, methodstr);
-  strcat(msg, file);
-  strcat(msg, versionstr);
-  strcat(msg, hoststr);
-  strcat(msg, host);
-  strcat(msg, termstr);
-
-  free(host);
-
-  int bytes_to_send = strlen(msg), bytes_send, total_bytes_send = 0;
-
-  while (total_bytes_send < bytes_to_send) {
-    bytes_send = send(sockfd, msg + total_bytes_send,
-                      bytes_to_send - total_bytes_send, 0);
-    if (bytes_send == -1)
-      return (NULL);
-    total_bytes_send += bytes_send;
-  }
-
-  free(msg);
-
-  char *target, buff[BUFF_LEN];
-
-  int bytes_recv;
-
-  target = (char *)malloc(sizeof(char));
-  if (target == NULL)
-    return (NULL);
-
-  *target = '\0';
-  while ((bytes_recv = recv(sockfd, buff, BUFF_LEN - 1, 0))) {
-
-    if (bytes_recv == -1)
-      return (NULL);
-
-    *total_bytes_recv += bytes_recv;
-    buff[bytes_recv] = '\0';
-
-    target = (char *)realloc(target, *total_bytes_recv + 1);
-    if (target == NULL)
-      return (NULL);
-    strcat(target, buff);
-  }
-
-  close(sockfd);
+void usage(const char *name) {
 
-  return (target);
+  fprintf(stderr,
+          "usage: %s [-e target] [-M ms] [-m MiB] [-s] [-T file] "
+          "[-x script] url [url ...]\n",
+          name);
+  exit(1);
 }
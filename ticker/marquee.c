@@ -0,0 +1,125 @@
+/**
+ *  @file   marquee.c
+ *  @brief  Headlines Crawling Along a Single Row
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "marquee.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int marquee_init(struct marquee *marquee) {
+
+  memset(marquee, 0, sizeof(struct marquee));
+
+  marquee->cells = (cchar_t *)calloc(MARQUEECELLS, sizeof(cchar_t));
+  marquee->col = (int *)calloc(MARQUEECELLS + 1, sizeof(int));
+  if (marquee->cells == NULL || marquee->col == NULL) {
+    marquee_free(marquee);
+    return (-1);
+  }
+
+  return (0);
+}
+
+void marquee_free(struct marquee *marquee) {
+
+  free(marquee->cells);
+  free(marquee->col);
+  marquee->cells = NULL;
+  marquee->col = NULL;
+}
+
+static void marquee_put(struct marquee *marquee, wchar_t wc, int cols,
+                        attr_t attr) {
+
+  wchar_t wch[2] = {wc, L'\0'};
+
+  setcchar(&marquee->cells[marquee->total], wch, attr, 0, NULL);
+  marquee->col[marquee->total + 1] = marquee->col[marquee->total] + cols;
+  ++marquee->total;
+}
+
+// the cells that fit in a row from the offset
+static void marquee_span(struct marquee *marquee) {
+
+  int *col = marquee->col;
+
+  if (marquee->end < marquee->offset)
+    marquee->end = marquee->offset;
+
+  while (marquee->end < marquee->total &&
+         col[marquee->end + 1] - col[marquee->offset] <= marquee->width)
+    ++marquee->end;
+}
+
+void marquee_build(struct marquee *marquee, struct store *store, int width) {
+
+  struct layout layout;
+  int budget = MARQUEECELLS - MARQUEEWIDTH,
+      nseparator = wcslen(MARQUEESEPARATOR), prepended = 0;
+
+  marquee->width = width < MARQUEEWIDTH ? width : MARQUEEWIDTH;
+  marquee->total = 0;
+
+  // combining marks are dropped, every cell holds a single character
+  for (unsigned long seq = store->next; seq > store->first;) {
+    int len;
+    const char *text = store_get(store, --seq, &len);
+    int n = store_layout(text, len, &layout);
+    if (marquee->total > 0 && marquee->total + n + nseparator > budget)
+      break;
+    for (int i = 0; i < n && marquee->total < budget; i++)
+      if (layout.cols[i] > 0)
+        marquee_put(marquee, layout.wide[i], layout.cols[i],
+                    seq & 1 ? A_BOLD : A_NORMAL);
+    for (int i = 0; i < nseparator && marquee->total < budget; i++)
+      marquee_put(marquee, MARQUEESEPARATOR[i], 1, A_NORMAL);
+    if (seq >= marquee->next)
+      prepended = marquee->total;
+  }
+
+  marquee->next = store->next;
+
+  marquee->len = marquee->total;
+
+  // a short strip repeats until it fills a row
+  for (int i = 0; marquee->len > 0 && marquee->col[marquee->total] -
+                                              marquee->col[marquee->len] <
+                                          marquee->width;
+       i = (i + 1) % marquee->len) {
+    marquee->cells[marquee->total] = marquee->cells[i];
+    marquee->col[marquee->total + 1] = marquee->col[marquee->total] +
+                                       marquee->col[i + 1] - marquee->col[i];
+    ++marquee->total;
+  }
+
+  marquee->offset =
+      marquee->len > 0 ? (marquee->offset + prepended) % marquee->len : 0;
+  marquee->end = marquee->offset;
+  marquee_span(marquee);
+}
+
+void marquee_step(struct marquee *marquee) {
+
+  if (marquee->len == 0)
+    return;
+
+  // back at the start, the end is found anew
+  if ((marquee->offset = (marquee->offset + 1) % marquee->len) == 0)
+    marquee->end = 0;
+  marquee_span(marquee);
+}
+
+void marquee_draw(struct marquee *marquee, WINDOW *win) {
+
+  werase(win);
+
+  if (marquee->end > marquee->offset)
+    mvwadd_wchnstr(win, 0, 0, marquee->cells + marquee->offset,
+                   marquee->end - marquee->offset);
+}
@@ -0,0 +1,44 @@
+/**
+ *  @file   marquee.h
+ *  @brief  Headlines Crawling Along a Single Row
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef MARQUEE_H_
+#define MARQUEE_H_
+
+#define NCURSES_WIDECHAR 1
+#include <ncurses.h>
+
+#include "store.h"
+
+#define MARQUEECELLS 8192
+#define MARQUEEWIDTH 1024 // widest row shown
+#define MARQUEESEPARATOR L" +++ "
+
+// the newest headlines laid out once as a strip of cells, newest first,
+// followed by as much of its start as fills a row, so that any row's worth
+// from an offset into the strip is a single copy
+struct marquee {
+  cchar_t *cells;
+  int *col; // columns before each cell
+  int len, total, offset, end, width;
+  unsigned long next; // of the store when last built
+};
+
+int marquee_init(struct marquee *marquee);
+void marquee_free(struct marquee *marquee);
+
+// on new headlines or a new width; the offset moves along with the cells
+// put in front of it, so the row shown stays put
+void marquee_build(struct marquee *marquee, struct store *store, int width);
+
+// moves the strip a character to the left
+void marquee_step(struct marquee *marquee);
+
+void marquee_draw(struct marquee *marquee, WINDOW *win);
+
+#endif // MARQUEE_H_
@@ -0,0 +1,228 @@
+/**
+ *  @file   resolve.c
+ *  @brief  Caching Asynchronous Resolver for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "resolve.h"
+#include "allocguard.h"
+#include "trace.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum resolve_state {
+  RESOLVE_EMPTY,
+  RESOLVE_PENDING,
+  RESOLVE_OK,
+  RESOLVE_FAILED
+};
+
+struct resolve_entry {
+  char host[RESOLVEHOST];
+  enum resolve_state state;
+  time_t expires, used;
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+};
+
+struct resolver {
+  struct resolve_entry entries[RESOLVEMAX];
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_t thread;
+  int fd[2];
+  bool quit;
+};
+
+static void *resolve_thread(void *arg) {
+
+  struct resolver *resolver = (struct resolver *)arg;
+  struct addrinfo hints, *info;
+  char host[RESOLVEHOST];
+
+  memset(&hints, 0, sizeof(struct addrinfo));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  trace_thread("resolver");
+
+  // getaddrinfo allocates, and lookups are off the frame loop anyway
+  allocguard_exempt();
+
+  pthread_mutex_lock(&resolver->lock);
+  while (!resolver->quit) {
+    struct resolve_entry *entry = NULL;
+    for (int i = 0; i < RESOLVEMAX && entry == NULL; i++)
+      if (resolver->entries[i].state == RESOLVE_PENDING)
+        entry = &resolver->entries[i];
+    if (entry == NULL) {
+      pthread_cond_wait(&resolver->wake, &resolver->lock);
+      continue;
+    }
+
+    strcpy(host, entry->host);
+    pthread_mutex_unlock(&resolver->lock);
+    struct trace_scope scope = trace_begin("resolve");
+    int status = getaddrinfo(host, NULL, &hints, &info);
+    trace_end(&scope);
+    pthread_mutex_lock(&resolver->lock);
+
+    // the slot may have been recycled while unlocked
+    if (entry->state == RESOLVE_PENDING && strcmp(entry->host, host) == 0) {
+      if (status == 0) {
+        memcpy(&entry->addr, info->ai_addr, info->ai_addrlen);
+        entry->addrlen = info->ai_addrlen;
+        entry->state = RESOLVE_OK;
+        entry->expires = time(NULL) + RESOLVETTL;
+      } else {
+        entry->state = RESOLVE_FAILED;
+        entry->expires = time(NULL) + RESOLVENEGTTL;
+      }
+    }
+    if (status == 0)
+      freeaddrinfo(info);
+
+    char byte = 0;
+    write(resolver->fd[1], &byte, 1);
+  }
+  pthread_mutex_unlock(&resolver->lock);
+
+  return (NULL);
+}
+
+struct resolver *resolve_create(void) {
+
+  struct resolver *resolver =
+      (struct resolver *)calloc(1, sizeof(struct resolver));
+  if (resolver == NULL)
+    return (NULL);
+
+  if (pipe(resolver->fd) == -1) {
+    free(resolver);
+    return (NULL);
+  }
+  fcntl(resolver->fd[0], F_SETFL, O_NONBLOCK);
+
+  pthread_mutex_init(&resolver->lock, NULL);
+  pthread_cond_init(&resolver->wake, NULL);
+
+  // signals must interrupt the select of the main thread
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  int status =
+      pthread_create(&resolver->thread, NULL, resolve_thread, resolver);
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (status != 0) {
+    close(resolver->fd[0]);
+    close(resolver->fd[1]);
+    free(resolver);
+    return (NULL);
+  }
+
+  return (resolver);
+}
+
+void resolve_destroy(struct resolver *resolver) {
+
+  if (resolver == NULL)
+    return;
+
+  pthread_mutex_lock(&resolver->lock);
+  resolver->quit = true;
+  pthread_cond_signal(&resolver->wake);
+  pthread_mutex_unlock(&resolver->lock);
+  pthread_join(resolver->thread, NULL);
+
+  close(resolver->fd[0]);
+  close(resolver->fd[1]);
+  free(resolver);
+}
+
+int resolve_fd(struct resolver *resolver) { return (resolver->fd[0]); }
+
+void resolve_clear(struct resolver *resolver) {
+
+  char bytes[64];
+  while (read(resolver->fd[0], bytes, sizeof(bytes)) > 0)
+    ;
+}
+
+int resolve_lookup(struct resolver *resolver, const char *host, int port,
+                   struct sockaddr_storage *addr, socklen_t *addrlen) {
+
+  time_t now = time(NULL);
+  struct resolve_entry *entry = NULL, *victim = NULL;
+  int status = 0;
+
+  if (strlen(host) >= RESOLVEHOST)
+    return (-1);
+
+  pthread_mutex_lock(&resolver->lock);
+
+  for (int i = 0; i < RESOLVEMAX; i++) {
+    struct resolve_entry *e = &resolver->entries[i];
+    if (e->state != RESOLVE_EMPTY && strcmp(e->host, host) == 0) {
+      entry = e;
+      break;
+    }
+    // least recently used slot that is not being looked up
+    if (e->state != RESOLVE_PENDING &&
+        (victim == NULL || e->state == RESOLVE_EMPTY ||
+         (victim->state != RESOLVE_EMPTY && e->used < victim->used)))
+      victim = e;
+  }
+
+  if (entry != NULL && entry->state != RESOLVE_PENDING &&
+      entry->expires <= now)
+    entry->state = RESOLVE_PENDING;
+
+  if (entry == NULL) {
+    if (victim == NULL) {
+      pthread_mutex_unlock(&resolver->lock);
+      return (0);
+    }
+    entry = victim;
+    strcpy(entry->host, host);
+    entry->state = RESOLVE_PENDING;
+  }
+
+  entry->used = now;
+
+  switch (entry->state) {
+  case RESOLVE_OK:
+    memcpy(addr, &entry->addr, entry->addrlen);
+    *addrlen = entry->addrlen;
+    if (addr->ss_family == AF_INET6)
+      ((struct sockaddr_in6 *)addr)->sin6_port = htons(port);
+    else
+      ((struct sockaddr_in *)addr)->sin_port = htons(port);
+    status = 1;
+    break;
+  case RESOLVE_FAILED:
+    status = -1;
+    break;
+  default:
+    pthread_cond_signal(&resolver->wake);
+    break;
+  }
+
+  pthread_mutex_unlock(&resolver->lock);
+
+  return (status);
+}
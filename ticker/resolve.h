@@ -0,0 +1,34 @@
+/**
+ *  @file   resolve.h
+ *  @brief  Caching Asynchronous Resolver for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef RESOLVE_H_
+#define RESOLVE_H_
+
+#include <sys/socket.h>
+
+#define RESOLVETTL 300
+#define RESOLVENEGTTL 30
+#define RESOLVEMAX 32
+#define RESOLVEHOST 256
+
+struct resolver;
+
+// lookups run on a helper thread, create it after fork()
+struct resolver *resolve_create(void);
+void resolve_destroy(struct resolver *resolver);
+
+// readable when a lookup completes, acknowledge with resolve_clear
+int resolve_fd(struct resolver *resolver);
+void resolve_clear(struct resolver *resolver);
+
+// 1: addr filled from the cache, 0: lookup pending, -1: host unknown
+int resolve_lookup(struct resolver *resolver, const char *host, int port,
+                   struct sockaddr_storage *addr, socklen_t *addrlen);
+
+#endif // RESOLVE_H_
@@ -0,0 +1,202 @@
+/**
+ *  @file   ring.c
+ *  @brief  Shared-Memory Ring Buffer for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#define _GNU_SOURCE
+
+#include "ring.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#endif
+
+#define RING_WRAP 0xFFFFFFFFu
+#define RING_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+struct ring_control {
+  _Atomic size_t head; // bytes ever produced
+  char pad[64 - sizeof(size_t)];
+  _Atomic size_t tail; // bytes ever consumed
+};
+
+struct ring {
+  struct ring_control *control;
+  char *data;
+  size_t size, map_size, reserved;
+  int data_fd, space_fd;
+  bool popped;
+};
+
+#ifdef __linux__
+
+struct ring *ring_create(size_t size) {
+
+  struct ring *ring = (struct ring *)calloc(1, sizeof(struct ring));
+  if (ring == NULL)
+    return (NULL);
+
+  ring->data_fd = ring->space_fd = -1;
+  ring->size = RING_ALIGN(size);
+  ring->map_size = sizeof(struct ring_control) + ring->size;
+
+  int memfd = memfd_create("ticker", MFD_CLOEXEC);
+  if (memfd == -1) {
+    free(ring);
+    return (NULL);
+  }
+
+  if (ftruncate(memfd, ring->map_size) == -1) {
+    close(memfd);
+    free(ring);
+    return (NULL);
+  }
+
+  void *map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   memfd, 0);
+  close(memfd);
+  if (map == MAP_FAILED) {
+    free(ring);
+    return (NULL);
+  }
+
+  ring->control = (struct ring_control *)map;
+  ring->data = (char *)map + sizeof(struct ring_control);
+  atomic_init(&ring->control->head, 0);
+  atomic_init(&ring->control->tail, 0);
+
+  ring->data_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  ring->space_fd = eventfd(0, EFD_CLOEXEC);
+  if (ring->data_fd == -1 || ring->space_fd == -1) {
+    ring_destroy(ring);
+    return (NULL);
+  }
+
+  return (ring);
+}
+
+void ring_destroy(struct ring *ring) {
+
+  if (ring == NULL)
+    return;
+
+  if (ring->data_fd != -1)
+    close(ring->data_fd);
+  if (ring->space_fd != -1)
+    close(ring->space_fd);
+  munmap(ring->control, ring->map_size);
+  free(ring);
+}
+
+#else
+
+struct ring *ring_create(size_t size) { return (NULL); }
+
+void ring_destroy(struct ring *ring) {}
+
+#endif
+
+int ring_fd(struct ring *ring) { return (ring->data_fd); }
+
+void ring_notify(struct ring *ring) {
+
+  uint64_t one = 1;
+  write(ring->data_fd, &one, sizeof(uint64_t));
+}
+
+char *ring_reserve(struct ring *ring, size_t len) {
+
+  size_t need = RING_ALIGN(sizeof(uint32_t) + len);
+  if (need > ring->size / 2)
+    return (NULL);
+
+  size_t head = atomic_load_explicit(&ring->control->head, memory_order_relaxed);
+
+  for (;;) {
+    size_t tail =
+        atomic_load_explicit(&ring->control->tail, memory_order_acquire);
+    size_t pos = head % ring->size, pad = 0;
+    if (ring->size - pos < need)
+      pad = ring->size - pos;
+    if (ring->size - (head - tail) >= pad + need) {
+      if (pad) {
+        *(uint32_t *)(ring->data + pos) = RING_WRAP;
+        head += pad;
+        atomic_store_explicit(&ring->control->head, head,
+                              memory_order_release);
+        pos = 0;
+      }
+      ring->reserved = need;
+      return (ring->data + pos + sizeof(uint32_t));
+    }
+    // full: make sure the consumer is awake before waiting on it
+    uint64_t count;
+    ring_notify(ring);
+    read(ring->space_fd, &count, sizeof(uint64_t));
+  }
+}
+
+void ring_commit(struct ring *ring, size_t len) {
+
+  size_t head = atomic_load_explicit(&ring->control->head, memory_order_relaxed);
+
+  *(uint32_t *)(ring->data + head % ring->size) = (uint32_t)len;
+  atomic_store_explicit(&ring->control->head, head + ring->reserved,
+                        memory_order_release);
+  ring->reserved = 0;
+}
+
+void ring_clear(struct ring *ring) {
+
+  uint64_t count;
+  read(ring->data_fd, &count, sizeof(uint64_t));
+}
+
+const char *ring_peek(struct ring *ring, int *len) {
+
+  size_t tail = atomic_load_explicit(&ring->control->tail, memory_order_relaxed);
+
+  for (;;) {
+    size_t head =
+        atomic_load_explicit(&ring->control->head, memory_order_acquire);
+    if (head == tail) {
+      // wake a producer waiting for space once per drain, not per record
+      if (ring->popped) {
+        uint64_t one = 1;
+        write(ring->space_fd, &one, sizeof(uint64_t));
+        ring->popped = false;
+      }
+      return (NULL);
+    }
+    size_t pos = tail % ring->size;
+    uint32_t size = *(uint32_t *)(ring->data + pos);
+    if (size != RING_WRAP) {
+      *len = (int)size;
+      return (ring->data + pos + sizeof(uint32_t));
+    }
+    tail += ring->size - pos;
+    atomic_store_explicit(&ring->control->tail, tail, memory_order_release);
+  }
+}
+
+void ring_pop(struct ring *ring) {
+
+  size_t tail = atomic_load_explicit(&ring->control->tail, memory_order_relaxed);
+  uint32_t size = *(uint32_t *)(ring->data + tail % ring->size);
+
+  atomic_store_explicit(&ring->control->tail,
+                        tail + RING_ALIGN(sizeof(uint32_t) + size),
+                        memory_order_release);
+  ring->popped = true;
+}
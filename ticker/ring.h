@@ -0,0 +1,38 @@
+/**
+ *  @file   ring.h
+ *  @brief  Shared-Memory Ring Buffer for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stddef.h>
+
+#define RINGSIZE (1 << 20)
+
+struct ring;
+
+// single-producer/single-consumer ring in a memfd mapping, must be created
+// before fork(); returns NULL where memfd/eventfd are unavailable
+struct ring *ring_create(size_t size);
+void ring_destroy(struct ring *ring);
+
+// eventfd that becomes readable when records are available
+int ring_fd(struct ring *ring);
+
+// producer: reserve room for a record of len bytes, fill it, then commit;
+// blocks while the consumer has the ring full
+char *ring_reserve(struct ring *ring, size_t len);
+void ring_commit(struct ring *ring, size_t len);
+void ring_notify(struct ring *ring);
+
+// consumer: acknowledge the wakeup, then peek/pop records in place
+void ring_clear(struct ring *ring);
+const char *ring_peek(struct ring *ring, int *len);
+void ring_pop(struct ring *ring);
+
+#endif // RING_H_
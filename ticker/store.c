@@ -0,0 +1,296 @@
+/**
+ *  @file   store.c
+ *  @brief  Bounded Headline Store for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#define _XOPEN_SOURCE 700 // wcwidth
+
+#include "store.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+#define STOREAVGLEN 96
+
+int store_init(struct store *store, size_t bytes) {
+
+  memset(store, 0, sizeof(struct store));
+
+  store->cap = bytes / (sizeof(struct headline) + STOREAVGLEN);
+  if (store->cap < 2)
+    return (-1);
+  store->text_size = bytes - store->cap * sizeof(struct headline);
+  if (store->text_size < STOREMAXLEN)
+    return (-1);
+
+  store->text = (char *)malloc(store->text_size);
+  store->lines =
+      (struct headline *)malloc(store->cap * sizeof(struct headline));
+  if (store->text == NULL || store->lines == NULL) {
+    store_free(store);
+    return (-1);
+  }
+
+  return (0);
+}
+
+void store_free(struct store *store) {
+
+  free(store->text);
+  free(store->lines);
+  store->text = NULL;
+  store->lines = NULL;
+}
+
+static long store_place(struct store *store, size_t len) {
+
+  if (store->first == store->next)
+    return (0);
+
+  size_t oldest = store->lines[store->first % store->cap].off,
+         newest = store->lines[(store->next - 1) % store->cap].off;
+
+  if (newest >= oldest) {
+    if (store->text_size - store->head >= len)
+      return ((long)store->head);
+    if (oldest >= len)
+      return (0);
+    return (-1);
+  }
+
+  if (oldest - store->head >= len)
+    return ((long)store->head);
+
+  return (-1);
+}
+
+unsigned long store_add(struct store *store, const char *text, size_t len) {
+
+  if (len > STOREMAXLEN)
+    len = STOREMAXLEN;
+
+  long off;
+  while (store->next - store->first >= store->cap ||
+         (off = store_place(store, len)) < 0)
+    ++store->first;
+
+  struct headline *h = &store->lines[store->next % store->cap];
+  h->off = (size_t)off;
+  h->len = (unsigned short)len;
+  h->width = 0;
+  h->nlines = 0;
+  memcpy(store->text + off, text, len);
+  store->head = off + len;
+
+  return (store->next++);
+}
+
+const char *store_get(struct store *store, unsigned long seq, int *len) {
+
+  if (seq < store->first || seq >= store->next)
+    return (NULL);
+
+  struct headline *h = &store->lines[seq % store->cap];
+  *len = h->len;
+  return (store->text + h->off);
+}
+
+static int store_utf8(const unsigned char *s, int len, wchar_t *wc) {
+
+  int size = s[0] < 0xe0 ? 2 : s[0] < 0xf0 ? 3 : 4;
+
+  if (s[0] < 0xc2 || s[0] > 0xf4 || size > len)
+    return (-1);
+
+  *wc = s[0] & (0x3f >> (size - 1));
+  for (int i = 1; i < size; i++) {
+    if ((s[i] & 0xc0) != 0x80)
+      return (-1);
+    *wc = (*wc << 6) | (s[i] & 0x3f);
+  }
+
+  // overlong forms, surrogates and beyond U+10FFFF
+  if ((size == 3 && (*wc < 0x800 || (*wc >= 0xd800 && *wc < 0xe000))) ||
+      (size == 4 && (*wc < 0x10000 || *wc > 0x10ffff)))
+    return (-1);
+
+  return (size);
+}
+
+int store_layout(const char *text, int len, struct layout *layout) {
+
+  const unsigned char *s = (const unsigned char *)text;
+  int n = 0, i = 0;
+
+  if (len > STOREMAXLEN)
+    len = STOREMAXLEN;
+
+  while (i < len) {
+    wchar_t wc = s[i];
+    int size = 1;
+    if (s[i] >= 0x80 && (size = store_utf8(s + i, len - i, &wc)) == -1) {
+      wc = 0xfffd;
+      size = 1;
+    }
+    // combining marks have no width and stay with their base character
+    int cols = wcwidth(wc);
+    if (cols < 0) {
+      wc = iswspace(wc) ? L' ' : L'?';
+      cols = 1;
+    }
+    layout->wide[n] = wc;
+    layout->cols[n] = cols;
+    layout->off[n++] = i;
+    i += size;
+  }
+
+  layout->text = text;
+  layout->off[n] = len;
+  layout->n = n;
+
+  return (n);
+}
+
+int store_wrap(struct layout *layout, int width, int *breaks, int max) {
+
+  int nlines = 0, pos = 0, n = layout->n;
+
+  if (width < 1)
+    width = 1;
+
+  do {
+    while (pos < n && layout->wide[pos] == L' ')
+      ++pos;
+    if (pos == n && nlines)
+      break;
+    if (breaks && nlines < max)
+      breaks[nlines] = pos;
+    ++nlines;
+    int end = pos, col = 0;
+    while (end < n && col + layout->cols[end] <= width)
+      col += layout->cols[end++];
+    if (end == n)
+      break;
+    int brk = end;
+    while (brk > pos && layout->wide[brk] != L' ')
+      --brk;
+    pos = brk > pos ? brk : end > pos ? end : pos + 1;
+  } while (pos < n);
+
+  return (nlines);
+}
+
+int store_lines(struct store *store, unsigned long seq, int width) {
+
+  struct headline *h = &store->lines[seq % store->cap];
+
+  if (h->width != width) {
+    struct layout layout;
+    store_layout(store->text + h->off, h->len, &layout);
+    h->nlines = store_wrap(&layout, width, NULL, 0);
+    h->width = width;
+  }
+
+  return (h->nlines);
+}
+
+void view_follow(struct store *store, struct view *view, int width) {
+
+  view->follow = true;
+  if (store->first == store->next) {
+    view->seq = store->next;
+    view->line = 0;
+    return;
+  }
+
+  view->seq = store->next - 1;
+  view->line = store_lines(store, view->seq, width) - 1;
+}
+
+static int view_forward(struct store *store, struct view *view, int width,
+                        int n) {
+
+  int moved = 0;
+
+  while (n > 0) {
+    int nlines = store_lines(store, view->seq, width);
+    if (view->line + n < nlines) {
+      view->line += n;
+      moved += n;
+      break;
+    }
+    if (view->seq + 1 == store->next) {
+      moved += nlines - 1 - view->line;
+      view->line = nlines - 1;
+      break;
+    }
+    n -= nlines - view->line;
+    moved += nlines - view->line;
+    ++view->seq;
+    view->line = 0;
+  }
+
+  return (moved);
+}
+
+static int view_back(struct store *store, struct view *view, int width,
+                     int n) {
+
+  int moved = 0;
+
+  while (n > 0) {
+    if (view->line >= n) {
+      view->line -= n;
+      moved += n;
+      break;
+    }
+    if (view->seq == store->first) {
+      moved += view->line;
+      view->line = 0;
+      break;
+    }
+    n -= view->line + 1;
+    moved += view->line + 1;
+    --view->seq;
+    view->line = store_lines(store, view->seq, width) - 1;
+  }
+
+  return (moved);
+}
+
+void view_scroll(struct store *store, struct view *view, int width, int delta,
+                 int rows) {
+
+  if (store->first == store->next)
+    return;
+
+  if (view->follow)
+    view_follow(store, view, width);
+
+  if (view->seq < store->first) {
+    view->seq = store->first;
+    view->line = 0;
+  }
+
+  int nlines = store_lines(store, view->seq, width);
+  if (view->line >= nlines)
+    view->line = nlines - 1;
+
+  if (delta < 0) {
+    view_back(store, view, width, -delta);
+    // keep the viewport full once the oldest headline is reached
+    struct view top = *view;
+    int above = view_back(store, &top, width, rows - 1);
+    if (above < rows - 1)
+      view_forward(store, view, width, rows - 1 - above);
+  } else
+    view_forward(store, view, width, delta);
+
+  view->follow = view->seq + 1 == store->next &&
+                 view->line == store_lines(store, view->seq, width) - 1;
+}
@@ -0,0 +1,71 @@
+/**
+ *  @file   store.h
+ *  @brief  Bounded Headline Store for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef STORE_H_
+#define STORE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <wchar.h>
+
+#define STOREMAXLEN 1024
+#define STOREMAXWRAP 256
+
+struct headline {
+  size_t off;
+  unsigned short len, width, nlines;
+};
+
+// ring of headlines in a fixed amount of memory, oldest are evicted first;
+// headlines are addressed by sequence number, valid in [first, next)
+struct store {
+  char *text;
+  size_t text_size, head;
+  struct headline *lines;
+  size_t cap;
+  unsigned long first, next;
+};
+
+// a headline decoded for display, off maps characters back to text
+struct layout {
+  const char *text;
+  int n;
+  wchar_t wide[STOREMAXLEN];
+  unsigned char cols[STOREMAXLEN];
+  unsigned short off[STOREMAXLEN + 1];
+};
+
+// bottom line of the viewport; follow sticks it to the newest headline
+struct view {
+  unsigned long seq;
+  int line;
+  bool follow;
+};
+
+int store_init(struct store *store, size_t bytes);
+void store_free(struct store *store);
+
+unsigned long store_add(struct store *store, const char *text, size_t len);
+const char *store_get(struct store *store, unsigned long seq, int *len);
+
+// number of wrapped lines at width, recomputed lazily when width changes
+int store_lines(struct store *store, unsigned long seq, int width);
+
+// single pass over UTF-8 text, invalid bytes become U+FFFD
+int store_layout(const char *text, int len, struct layout *layout);
+
+// greedy word wrap on display columns; fills breaks with the character
+// each line starts at when not NULL
+int store_wrap(struct layout *layout, int width, int *breaks, int max);
+
+void view_follow(struct store *store, struct view *view, int width);
+void view_scroll(struct store *store, struct view *view, int width, int delta,
+                 int rows);
+
+#endif // STORE_H_
@@ -0,0 +1,225 @@
+/**
+ *  @file   worker.c
+ *  @brief  Persistent Script Runner for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#include "worker.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct worker {
+  pid_t pid;
+  int in, out;
+  char buf[2 * WORKERLINE];
+  int len, next;
+  bool gone, reaped;
+};
+
+static void worker_exec(const char *script, const char *line) {
+
+  static const char errstr[] = "unable to run the script\n";
+
+  pid_t pid = fork();
+
+  if (pid == 0) {
+    int null = open("/dev/null", O_RDONLY);
+    if (null != -1)
+      dup2(null, STDIN_FILENO);
+    execl(script, script, line, (char *)NULL);
+    write(STDOUT_FILENO, errstr, sizeof(errstr) - 1);
+    _exit(127);
+  }
+
+  while (pid > 0 && waitpid(pid, NULL, 0) == -1 && errno == EINTR)
+    ;
+}
+
+// the worker's loop, its stdin has the lines, its stdout the output
+static void worker_run(const char *script) {
+
+  char lines[WORKERLINE];
+  int len = 0;
+
+  while (true) {
+    ssize_t n = read(STDIN_FILENO, lines + len, WORKERLINE - len);
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    len += n;
+    char *newline;
+    while ((newline = memchr(lines, '\n', len)) != NULL) {
+      *newline = '\0';
+      worker_exec(script, lines);
+      len -= newline + 1 - lines;
+      memmove(lines, newline + 1, len);
+    }
+    // an overlong line is cut
+    if (len == WORKERLINE) {
+      lines[len - 1] = '\0';
+      worker_exec(script, lines);
+      len = 0;
+    }
+  }
+
+  _exit(0);
+}
+
+struct worker *worker_start(const char *script) {
+
+  int in[2], out[2];
+
+  struct worker *worker = (struct worker *)calloc(1, sizeof(struct worker));
+  if (worker == NULL)
+    return (NULL);
+
+  if (pipe(in) == -1) {
+    free(worker);
+    return (NULL);
+  }
+
+  if (pipe(out) == -1) {
+    close(in[0]);
+    close(in[1]);
+    free(worker);
+    return (NULL);
+  }
+
+  if ((worker->pid = fork()) == -1) {
+    close(in[0]);
+    close(in[1]);
+    close(out[0]);
+    close(out[1]);
+    free(worker);
+    return (NULL);
+  }
+
+  if (worker->pid == 0) {
+    // a group of its own, so stopping it takes the script along
+    setpgid(0, 0);
+    signal(SIGQUIT, SIG_DFL);
+    signal(SIGPIPE, SIG_DFL);
+    dup2(in[0], STDIN_FILENO);
+    dup2(out[1], STDOUT_FILENO);
+    dup2(out[1], STDERR_FILENO);
+    // nothing of the client's is kept open
+    long maxfd = sysconf(_SC_OPEN_MAX);
+    if (maxfd <= 0 || maxfd > 1024)
+      maxfd = 1024;
+    for (int fd = STDERR_FILENO + 1; fd < maxfd; fd++)
+      close(fd);
+    worker_run(script);
+  }
+
+  // in the parent too, so the group exists whichever of them runs first
+  setpgid(worker->pid, worker->pid);
+
+  close(in[0]);
+  close(out[1]);
+
+  worker->in = in[1];
+  worker->out = out[0];
+  fcntl(worker->in, F_SETFL, O_NONBLOCK);
+  fcntl(worker->out, F_SETFL, O_NONBLOCK);
+
+  return (worker);
+}
+
+void worker_stop(struct worker *worker) {
+
+  if (worker == NULL)
+    return;
+
+  close(worker->in);
+  close(worker->out);
+
+  if (!worker->reaped) {
+    kill(-worker->pid, SIGTERM);
+    while (waitpid(worker->pid, NULL, 0) == -1 && errno == EINTR)
+      ;
+  }
+
+  free(worker);
+}
+
+int worker_send(struct worker *worker, const char *line, int len) {
+
+  if (worker->gone || len >= PIPE_BUF)
+    return (-1);
+
+  char buf[PIPE_BUF];
+
+  memcpy(buf, line, len);
+  buf[len] = '\n';
+
+  // short enough to go in whole or not at all
+  return (write(worker->in, buf, len + 1) == len + 1 ? 0 : -1);
+}
+
+int worker_fd(struct worker *worker) { return (worker->out); }
+
+int worker_read(struct worker *worker) {
+
+  // consumed lines make room first
+  if (worker->next > 0) {
+    worker->len -= worker->next;
+    memmove(worker->buf, worker->buf + worker->next, worker->len);
+    worker->next = 0;
+  }
+
+  ssize_t n = read(worker->out, worker->buf + worker->len,
+                   sizeof(worker->buf) - worker->len);
+
+  if (n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR)) {
+    worker->gone = true;
+    // the worker exits once its output is closed, often just after; whatever
+    // it still runs is of no use without it, so it is stopped and reaped now
+    if (waitpid(worker->pid, NULL, WNOHANG) == 0) {
+      kill(-worker->pid, SIGTERM);
+      while (waitpid(worker->pid, NULL, 0) == -1 && errno == EINTR)
+        ;
+    }
+    worker->reaped = true;
+    return (0);
+  }
+
+  if (n > 0)
+    worker->len += n;
+
+  return (1);
+}
+
+const char *worker_line(struct worker *worker, int *len) {
+
+  int avail = worker->len - worker->next;
+  char *line = worker->buf + worker->next,
+       *newline = memchr(line, '\n', avail < WORKERLINE ? avail : WORKERLINE);
+
+  if (newline != NULL) {
+    *len = newline - line;
+    worker->next += *len + 1;
+  } else if (avail >= WORKERLINE || (worker->gone && avail > 0)) {
+    *len = avail < WORKERLINE ? avail : WORKERLINE;
+    worker->next += *len;
+  } else
+    return (NULL);
+
+  // control characters would break the headlines
+  for (int i = 0; i < *len; i++)
+    if ((unsigned char)line[i] < ' ')
+      line[i] = ' ';
+
+  return (line);
+}
@@ -0,0 +1,35 @@
+/**
+ *  @file   worker.h
+ *  @brief  Persistent Script Runner for Ticker
+ *  @author KrizTioaN (christiaanboersma@hotmail.com)
+ *  @date   2026-10-19
+ *  @note   BSD-3 licensed
+ *
+ ***********************************************/
+
+#ifndef WORKER_H_
+#define WORKER_H_
+
+#define WORKERLINE 512
+
+struct worker;
+
+// a small process that runs script with each line sent to it as its only
+// argument, one after the other, and passes back what it prints; start it
+// before the windows are allocated, it is all that is ever forked
+struct worker *worker_start(const char *script);
+
+// stops the worker, along with a script that is still running, and reaps it
+void worker_stop(struct worker *worker);
+
+// -1 when the worker is gone or behind by a pipe full of lines
+int worker_send(struct worker *worker, const char *line, int len);
+
+// readable when the script printed something, take it with worker_read,
+// which returns 0 once the worker is gone, then collect worker_line until
+// it returns NULL; longer lines come in pieces of WORKERLINE
+int worker_fd(struct worker *worker);
+int worker_read(struct worker *worker);
+const char *worker_line(struct worker *worker, int *len);
+
+#endif // WORKER_H_